@@ -0,0 +1,150 @@
+// what the application draws each frame, independent of where its events come from and where its frames go
+
+const Pixel BACKGROUND_COLOR = WHITE;
+const u64 MAIN_INPUT_X = 100;
+const u64 MAIN_INPUT_Y = 100;
+const u64 MAIN_INPUT_WIDTH = 200;
+const u64 MAIN_INPUT_HEIGHT = 40;
+const u64 MAIN_INPUT_FONT_SIZE = 32;
+const u64 MAIN_INPUT_COUNT = 3; // in a column, the first one has the focus
+const u64 MAIN_INPUT_SPACING = 20;
+const u64 DOCUMENT_X = MAIN_INPUT_X + MAIN_INPUT_WIDTH + MAIN_INPUT_SPACING; // right of the inputs
+const u64 DOCUMENT_Y = MAIN_INPUT_Y;
+const u64 DOCUMENT_MARGIN = 20; // to the window's right and bottom edges
+const u64 DOCUMENT_FONT_SIZE = 16;
+const u64 DOCUMENT_SEARCH_INPUT_INDEX = MAIN_INPUT_COUNT - 1; // what's typed into it gets highlighted in the document
+const bool SHOULD_LOCK_FRAMEBUFFERS = false; // mlock, needs a big enough RLIMIT_MEMLOCK
+
+u64 get_main_input_y(u64 index)
+{
+    return MAIN_INPUT_Y + index * (MAIN_INPUT_HEIGHT + MAIN_INPUT_SPACING);
+}
+
+InputWidgets create_main_inputs()
+{
+    auto result = InputWidgets::allocate();
+    for (u64 i = 0; i < MAIN_INPUT_COUNT; i++)
+    {
+        result.add(InputState::construct(
+            Vector2<u64>::construct(MAIN_INPUT_X, get_main_input_y(i)),
+            Vector2<u64>::construct(MAIN_INPUT_WIDTH, MAIN_INPUT_HEIGHT),
+            MAIN_INPUT_FONT_SIZE
+        ));
+    }
+    return result;
+}
+
+// the inputs keep their places, and get cut off by the window's edges when the window is too small for them
+void layout_main_inputs(InputWidgets* widgets, u64 width, u64 height)
+{
+    for (u64 i = 0; i < widgets->inputs.size; i++)
+    {
+        auto input_state = &widgets->inputs.data[i];
+        auto y = get_main_input_y(i);
+        input_state->dimensions.x = min(MAIN_INPUT_WIDTH, width > MAIN_INPUT_X ? width - MAIN_INPUT_X : 0);
+        input_state->dimensions.y = min(MAIN_INPUT_HEIGHT, height > y ? height - y : 0);
+        input_state->is_layout_dirty = true;
+    }
+    widgets->on_layout_changed();
+}
+
+Vector2<u64> get_document_dimensions(u64 width, u64 height)
+{
+    return Vector2<u64>::construct(
+        width > DOCUMENT_X + DOCUMENT_MARGIN ? width - DOCUMENT_X - DOCUMENT_MARGIN : 0,
+        height > DOCUMENT_Y + DOCUMENT_MARGIN ? height - DOCUMENT_Y - DOCUMENT_MARGIN : 0
+    );
+}
+
+// inputs too small to be drawn still get typed into; `document` is the file given on the command line, if any,
+// DocumentView::update indexes and searches it once before the frame's windows render
+void render_frame(InputWidgets* widgets, DocumentView* document, List<X11Event> events, Image image)
+{
+    image.clear(BACKGROUND_COLOR);
+    widgets->render(events, image);
+    if (document != nullptr)
+    {
+        auto dimensions = get_document_dimensions(image.width, image.height);
+        document->handle_events(events, dimensions.y);
+        auto search = document->has_search ? &document->search : nullptr;
+        document->render(image, Vector2<u64>::construct(DOCUMENT_X, DOCUMENT_Y), dimensions, search);
+    }
+}
+
+// called for every window before DocumentView::update: the needle is what was typed last into the search input
+// of any of them, it takes effect the frame after
+void search_document_for_input(DocumentView* document, InputWidgets* widgets)
+{
+    if (DOCUMENT_SEARCH_INPUT_INDEX < widgets->inputs.size)
+    {
+        document->search_for(&widgets->inputs.data[DOCUMENT_SEARCH_INPUT_INDEX].text);
+    }
+}
+
+// the document shown next to the inputs: argv[1], when there is one and it can be mapped
+Option<DocumentView> open_command_line_document()
+{
+    auto path = get_command_line_argument(1);
+    if (!path.has_data)
+    {
+        return Option<DocumentView>::empty();
+    }
+    auto result = DocumentView::open(path.value, DOCUMENT_FONT_SIZE);
+    if (!result.has_data)
+    {
+        print("Failed to open ", path.value, ", showing no document\n");
+    }
+    return result;
+}
+
+// a top-level window's share of the application: a framebuffer, inputs and the events that were sent to it;
+// glyphs and fonts are shared by all windows
+struct AppWindow
+{
+    Image image;
+    InputWidgets inputs;
+    DocumentView* document; // shared by all windows, nullptr without one
+    List<X11Event> events; // of the current frame
+
+    static AppWindow allocate(u64 width, u64 height, DocumentView* document)
+    {
+        AppWindow result;
+        result.image = Image::allocate_in_pages(width, height, SHOULD_LOCK_FRAMEBUFFERS);
+        result.inputs = create_main_inputs();
+        layout_main_inputs(&result.inputs, width, height);
+        result.document = document;
+        result.events = List<X11Event>::allocate();
+        return result;
+    }
+
+    void deallocate()
+    {
+        events.deallocate();
+        inputs.deallocate();
+        image.deallocate();
+    }
+
+    void resize(u64 width, u64 height)
+    {
+        image.resize(width, height);
+        layout_main_inputs(&inputs, width, height);
+    }
+
+    void render()
+    {
+        // an interactive resize sends a burst of ConfigureNotify per frame, only the last one matters
+        for (auto i = events.size; i > 0; i--)
+        {
+            if (events.data[i - 1].type == X11EventTypeConfigureNotify)
+            {
+                auto configure_notify = (X11EventConfigureNotify*)&events.data[i - 1];
+                if (configure_notify->width != image.width || configure_notify->height != image.height)
+                {
+                    resize(configure_notify->width, configure_notify->height);
+                }
+                break;
+            }
+        }
+        render_frame(&inputs, document, events, image);
+    }
+};
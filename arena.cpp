@@ -0,0 +1,59 @@
+// scratch memory for a frame's worth of work, like the cells PathRasterizer::fill sorts: allocating is a pointer
+// bump, and everything is freed at once when the owner resets the arena; the address space is reserved up front
+// and pages are only backed once they are touched, so a big reservation costs nothing until it's actually needed;
+// the application's own frames draw straight into views and need none of it
+
+const u64 FRAME_ARENA_SIZE = 256 * 1024 * 1024;
+const u64 ARENA_DEFAULT_ALIGNMENT = 64; // a cache line
+
+// heap allocations made by this tree's own code, mystd's containers growing aren't counted;
+// lets the frame loop check that steady-state frames don't allocate
+u64 heap_allocation_count;
+
+byte* heap_allocate(u64 size)
+{
+    heap_allocation_count++;
+    return default_allocate(size);
+}
+
+struct Arena
+{
+    byte* data;
+    u64 size;
+    u64 used;
+
+    static Arena allocate(u64 size)
+    {
+        Arena result;
+        result.data = map_memory(size, LINUX_PROTECTION_READ | LINUX_PROTECTION_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS);
+        assert(result.data != nullptr, "Arena::allocate: failed to reserve ", size, " bytes");
+        result.size = size;
+        result.used = 0;
+        return result;
+    }
+
+    void deallocate()
+    {
+        unmap_memory(data, size);
+    }
+
+    // `alignment` has to be a power of two
+    byte* push(u64 push_size, u64 alignment = ARENA_DEFAULT_ALIGNMENT)
+    {
+        auto start = (used + alignment - 1) & ~(alignment - 1);
+        assert(start + push_size <= size, "Arena::push: out of memory, ", push_size, " bytes requested");
+        used = start + push_size;
+        return data + start;
+    }
+
+    template <typename T>
+    T* push_array(u64 count, u64 alignment = ARENA_DEFAULT_ALIGNMENT)
+    {
+        return (T*)push(count * sizeof(T), alignment);
+    }
+
+    void reset()
+    {
+        used = 0;
+    }
+};
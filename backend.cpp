@@ -0,0 +1,306 @@
+// where frames go: onto the X11 window, paced to the display, or into memory and optionally files,
+// as fast as they can be rendered and with events from a script, which needs no display at all
+
+const u64 FRAME_TIME = 16 * 1000 * 1000; // in nanoseconds, ~60 FPS
+
+enum RenderBackendType : u8
+{
+    RenderBackendTypeX11,
+    RenderBackendTypeOffscreen,
+};
+
+enum OffscreenDumpFormat : u8
+{
+    OffscreenDumpFormatNone, // frames only live in the Image they were rendered into
+    OffscreenDumpFormatPpm,
+    OffscreenDumpFormatRaw, // the Image's pixels as they are, 0x00RRGGBB little-endian, without row padding
+};
+
+struct ScriptedEvent
+{
+    u64 frame_index;
+    X11Event event;
+};
+
+struct EventScript
+{
+    List<ScriptedEvent> events; // sorted by frame
+    u64 next_event;
+
+    static EventScript allocate()
+    {
+        EventScript result;
+        result.events = List<ScriptedEvent>::allocate();
+        result.next_event = 0;
+        return result;
+    }
+
+    void deallocate()
+    {
+        events.deallocate();
+    }
+
+    void push_key_press(u64 frame_index, X11KeyCode key_code, X11ModifierKey modifiers = (X11ModifierKey)0)
+    {
+        ScriptedEvent scripted;
+        scripted.frame_index = frame_index;
+        auto key_press = (X11EventKeyPress*)&scripted.event;
+        *key_press = {};
+        key_press->type = X11EventTypeKeyPress;
+        key_press->key_code = key_code;
+        key_press->time = frame_index * FRAME_TIME / (1000 * 1000); // as if every frame took exactly FRAME_TIME
+        key_press->state = modifiers;
+        key_press->same_screen = true;
+        events.push(scripted);
+    }
+
+    // `position` is in the window
+    void push_button_press(u64 frame_index, X11Button button, Vector2<u64> position)
+    {
+        ScriptedEvent scripted;
+        scripted.frame_index = frame_index;
+        auto button_press = (X11EventKeyPress*)&scripted.event; // same layout
+        *button_press = {};
+        button_press->type = X11EventTypeButtonPress;
+        button_press->key_code = (X11KeyCode)button;
+        button_press->time = frame_index * FRAME_TIME / (1000 * 1000);
+        button_press->event_x = position.x;
+        button_press->event_y = position.y;
+        button_press->same_screen = true;
+        events.push(scripted);
+    }
+
+    // one key press every `frames_per_key` frames, characters without a key are skipped;
+    // returns the first frame after the text
+    u64 push_text(u64 frame_index, String text, u64 frames_per_key = 1)
+    {
+        for (u64 i = 0; i < text.size; i++)
+        {
+            X11ModifierKey modifier_options[] = {(X11ModifierKey)0, X11ModifierKeyShift};
+            for (auto modifiers : modifier_options)
+            {
+                auto maybe_key_code = find_key_code(text.data[i], modifiers);
+                if (maybe_key_code.has_data)
+                {
+                    push_key_press(frame_index, maybe_key_code.value, modifiers);
+                    frame_index += frames_per_key;
+                    break;
+                }
+            }
+        }
+        return frame_index;
+    }
+
+    // the inverse of X11EventKeyPress::to_char
+    static Option<X11KeyCode> find_key_code(char character, X11ModifierKey modifiers)
+    {
+        X11EventKeyPress key_press = {};
+        key_press.state = modifiers;
+        for (u64 key_code = 0; key_code < 256; key_code++)
+        {
+            key_press.key_code = (X11KeyCode)key_code;
+            auto maybe_char = key_press.to_char();
+            if (maybe_char.has_data && maybe_char.value == character)
+            {
+                return Option<X11KeyCode>::construct((X11KeyCode)key_code);
+            }
+        }
+        return Option<X11KeyCode>::empty();
+    }
+
+    void read_events(u64 frame_index, List<X11Event>* result)
+    {
+        while (next_event < events.size && events.data[next_event].frame_index <= frame_index)
+        {
+            result->push(events.data[next_event].event);
+            next_event++;
+        }
+    }
+
+    bool is_done()
+    {
+        return next_event == events.size;
+    }
+};
+
+struct RenderBackend
+{
+    RenderBackendType type;
+    u64 frame_index;
+
+    // RenderBackendTypeX11
+    X11Connection* connection;
+    List<X11Window> windows; // every window is presented into separately, and all of them are flushed together
+
+    // RenderBackendTypeOffscreen
+    EventScript* script;
+    OffscreenDumpFormat dump_format;
+    CStringView dump_path_prefix; // frame files are named <prefix><frame index>.ppm or .raw
+    String dump_buffer;
+
+    static RenderBackend construct_x11(X11Connection* connection)
+    {
+        RenderBackend result = {};
+        result.type = RenderBackendTypeX11;
+        result.connection = connection;
+        result.windows = List<X11Window>::allocate();
+        return result;
+    }
+
+    static RenderBackend construct_offscreen(EventScript* script, OffscreenDumpFormat dump_format = OffscreenDumpFormatNone, CStringView dump_path_prefix = "frame_")
+    {
+        RenderBackend result = {};
+        result.type = RenderBackendTypeOffscreen;
+        result.script = script;
+        result.dump_format = dump_format;
+        result.dump_path_prefix = dump_path_prefix;
+        result.dump_buffer = String::allocate();
+        return result;
+    }
+
+    void dispose()
+    {
+        switch (type)
+        {
+            case RenderBackendTypeX11: windows.deallocate(); break;
+            case RenderBackendTypeOffscreen: dump_buffer.deallocate(); break;
+        }
+    }
+
+    // returns the index that the window's frames are presented with
+    u64 add_window(X11Window window)
+    {
+        windows.push(window);
+        return windows.size - 1;
+    }
+
+    // windows are few enough to look up linearly, an event is dispatched after a few compares
+    Option<u64> find_window(u32 x11_window_id)
+    {
+        for (u64 i = 0; i < windows.size; i++)
+        {
+            if (windows.data[i].id == x11_window_id)
+            {
+                return Option<u64>::construct(i);
+            }
+        }
+        return Option<u64>::empty();
+    }
+
+    // X11 events are read by the caller, along with the replies that only it knows what to do with
+    void read_scripted_events(List<X11Event>* events)
+    {
+        if (type == RenderBackendTypeOffscreen)
+        {
+            script->read_events(frame_index, events);
+        }
+    }
+
+    // X11 frames only go out in end_frame, `image` has to stay unchanged until then
+    void present(Image image, u64 window_index = 0)
+    {
+        switch (type)
+        {
+            case RenderBackendTypeX11: put_image_in_chunks(connection, windows.data[window_index], image); break;
+            case RenderBackendTypeOffscreen: dump_frame(image); break;
+        }
+    }
+
+    // sends everything the frame queued for every window at once and waits for the next frame on a display,
+    // moves straight on to it offscreen
+    void end_frame()
+    {
+        if (type == RenderBackendTypeX11)
+        {
+            connection->flush();
+            SleepTime sleep_time;
+            sleep_time.seconds = 0;
+            sleep_time.nanoseconds = FRAME_TIME;
+            nanosleep(&sleep_time);
+        }
+        frame_index++;
+    }
+
+    void dump_frame(Image image)
+    {
+        if (dump_format == OffscreenDumpFormatNone)
+        {
+            return;
+        }
+
+        char path[256];
+        auto prefix_size = get_c_string_length(dump_path_prefix);
+        assert(prefix_size + 16 < sizeof(path), "RenderBackend::dump_frame: path prefix is too long");
+        copy_memory(dump_path_prefix, prefix_size, path);
+        auto path_end = path + prefix_size;
+        for (u64 divisor = 100000; divisor != 0; divisor /= 10)
+        {
+            *path_end = '0' + frame_index / divisor % 10;
+            path_end++;
+        }
+        auto extension = dump_format == OffscreenDumpFormatPpm ? ".ppm" : ".raw";
+        copy_memory(extension, 5, path_end); // with the zero terminator
+
+        auto maybe_file = open_file_for_writing(path);
+        assert(maybe_file.has_data, "Failed to open ", (CStringView)path, " for writing");
+        auto file = maybe_file.value;
+        if (dump_format == OffscreenDumpFormatRaw)
+        {
+            auto row_size = image.width * sizeof(Pixel);
+            for (u64 y = 0; y < image.height; y++)
+            {
+                auto write_result = write(file, image.data + y * image.stride, row_size);
+                assert(write_result == (s64)row_size, "Failed to write ", (CStringView)path);
+            }
+        }
+        else
+        {
+            dump_buffer.clear();
+            push_ppm_header(image.width, image.height);
+            for (u64 y = 0; y < image.height; y++)
+            {
+                for (u64 x = 0; x < image.width; x++)
+                {
+                    auto pixel = image.data[y * image.stride + x];
+                    dump_buffer.push((char)(pixel >> 16));
+                    dump_buffer.push((char)(pixel >> 8));
+                    dump_buffer.push((char)pixel);
+                }
+            }
+            auto write_result = write(file, dump_buffer.data, dump_buffer.size);
+            assert(write_result == (s64)dump_buffer.size, "Failed to write ", (CStringView)path);
+        }
+        close(file);
+    }
+
+    void push_ppm_header(u64 width, u64 height)
+    {
+        dump_buffer.push('P');
+        dump_buffer.push('6');
+        dump_buffer.push('\n');
+        push_decimal(width);
+        dump_buffer.push(' ');
+        push_decimal(height);
+        dump_buffer.push('\n');
+        push_decimal(255);
+        dump_buffer.push('\n');
+    }
+
+    void push_decimal(u64 value)
+    {
+        char digits[20];
+        u64 digit_count = 0;
+        do
+        {
+            digits[digit_count] = '0' + value % 10;
+            digit_count++;
+            value /= 10;
+        }
+        while (value != 0);
+        while (digit_count != 0)
+        {
+            digit_count--;
+            dump_buffer.push(digits[digit_count]);
+        }
+    }
+};
@@ -0,0 +1,1069 @@
+// headless microbenchmarks of the rendering and upload hot paths, built next to main.bin by run.sh;
+// every number is the median of several batches that each run for a fixed time, after a warm-up
+
+#include <mystd/include_linux.h>
+
+#pragma pack(push, 1)
+
+#include "syscalls.cpp"
+#include "profiler.cpp"
+#include "arena.cpp"
+#include "page_allocator.cpp"
+#include "utf8.cpp"
+#include "codepoint_map.cpp"
+#include "byte_search.cpp"
+#include "x11.cpp"
+#include "x11_trace.cpp"
+#include "x11_connection.cpp"
+#include "renderer.cpp"
+#include "blit.cpp"
+#include "path_rasterizer.cpp"
+#include "text_renderer.cpp"
+#include "font_loader.cpp"
+#include "gap_buffer.cpp"
+#include "input_renderer.cpp"
+#include "input_widgets.cpp"
+#include "text_search.cpp"
+#include "document_view.cpp"
+#include "x11_client.cpp"
+#include "app.cpp"
+
+const u64 BENCHMARK_WARM_UP_TIME = 50 * 1000 * 1000; // in nanoseconds
+const u64 BENCHMARK_BATCH_TIME = 10 * 1000 * 1000; // in nanoseconds
+const u64 BENCHMARK_BATCH_COUNT = 15;
+
+// `value` is scaled by 10^decimal_count
+void print_fixed(u64 value, u64 decimal_count)
+{
+    u64 divisor = 1;
+    for (u64 i = 0; i < decimal_count; i++)
+    {
+        divisor *= 10;
+    }
+    print(value / divisor, ".");
+    for (auto digit_divisor = divisor / 10; digit_divisor != 0; digit_divisor /= 10)
+    {
+        print((u64)(value / digit_divisor % 10));
+    }
+}
+
+struct BenchmarkBatch
+{
+    u64 nanoseconds;
+    u64 ticks;
+};
+
+// `pixel_count` and `byte_count` are per operation: pixels touched, and bytes produced or consumed;
+// ticks of the time stamp counter stand in for cycles, they match at the nominal clock rate
+template <typename Operation>
+void run_benchmark(CStringView name, u64 pixel_count, u64 byte_count, Operation operation)
+{
+    // warm up, doubling the number of operations until one batch of them takes long enough to time
+    u64 operation_count = 1;
+    auto warm_up_start = get_monotonic_time();
+    while (true)
+    {
+        auto start = get_monotonic_time();
+        for (u64 i = 0; i < operation_count; i++)
+        {
+            operation();
+        }
+        auto end = get_monotonic_time();
+        if (end - start < BENCHMARK_BATCH_TIME)
+        {
+            operation_count *= 2;
+        }
+        else if (end - warm_up_start >= BENCHMARK_WARM_UP_TIME)
+        {
+            break;
+        }
+    }
+
+    BenchmarkBatch batches[BENCHMARK_BATCH_COUNT];
+    for (u64 batch_i = 0; batch_i < BENCHMARK_BATCH_COUNT; batch_i++)
+    {
+        auto start = get_monotonic_time();
+        auto start_ticks = read_time_stamp_counter();
+        for (u64 i = 0; i < operation_count; i++)
+        {
+            operation();
+        }
+        batches[batch_i].ticks = read_time_stamp_counter() - start_ticks;
+        batches[batch_i].nanoseconds = get_monotonic_time() - start;
+
+        // insertion sort by time, the batches are few
+        for (auto i = batch_i; i > 0 && batches[i].nanoseconds < batches[i - 1].nanoseconds; i--)
+        {
+            auto swapped = batches[i];
+            batches[i] = batches[i - 1];
+            batches[i - 1] = swapped;
+        }
+    }
+
+    auto median = batches[BENCHMARK_BATCH_COUNT / 2];
+    auto fastest = batches[0];
+    print(name, ": ");
+    print_fixed(median.nanoseconds * 10 / operation_count, 1);
+    print(" ns/op (fastest ");
+    print_fixed(fastest.nanoseconds * 10 / operation_count, 1);
+    print(")");
+    if (byte_count != 0)
+    {
+        print(", ");
+        print_fixed(byte_count * operation_count * 1000 * 100 / median.nanoseconds, 2);
+        print(" MB/s");
+    }
+    if (pixel_count != 0)
+    {
+        print(", ");
+        print_fixed(median.ticks * 100 / (operation_count * pixel_count), 2);
+        print(" cycles/pixel");
+    }
+    print("\n");
+}
+
+const char BENCHMARK_TEXT[] =
+    "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs. "
+    "How vexingly quick daft zebras jump! Sphinx of black quartz, judge my vow. "
+    "The five boxing wizards jump quickly. Jackdaws love my big sphinx of quartz. "
+    "Waltz, bad nymph, for quick jigs vex. Glib jocks quiz nymph to vex dwarf. ";
+
+String get_benchmark_text(u64 size)
+{
+    String result;
+    result.data = (char*)BENCHMARK_TEXT;
+    result.size = min(size, (u64)sizeof(BENCHMARK_TEXT) - 1);
+    return result;
+}
+
+// xorshift64, deterministic so runs compare
+u64 get_next_benchmark_random(u64* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+CStringView BENCHMARK_PSF2_PATH = "/tmp/benchmark_font.psf";
+CStringView BENCHMARK_BDF_PATH = "/tmp/benchmark_font.bdf";
+const u8 BENCHMARK_PSF2_GLYPH_ROW = 0x5A; // every row of the second glyph, the first one's are 0xFF
+// a multi-codepoint sequence doesn't count, so 4 codepoints are mapped: A, é and Ж to the second glyph, € to the
+// first one
+const char BENCHMARK_PSF2_UNICODE_TABLE[] = "\xE2\x82\xAC\xFF" "A\xC3\xA9\xD0\x96\xFE" "e\xCC\x81\xFF";
+const char BENCHMARK_BDF_TEXT[] =
+    "STARTFONT 2.1\n"
+    "FONTBOUNDINGBOX 8 16 0 -4\n"
+    "CHARS 3\n"
+    "STARTCHAR A\nENCODING 65\nBBX 8 2 0 0\nBITMAP\n18\n3C\nENDCHAR\n"
+    "STARTCHAR euro\nENCODING 8364\nBBX 6 3 1 2\nBITMAP\nF8\n80\nF0\nENDCHAR\n"
+    "STARTCHAR shifted out of a u64\nENCODING 8365\nBBX 8 1 70 0\nBITMAP\nFF\nENDCHAR\n"
+    "ENDFONT\n";
+
+void write_benchmark_file(CStringView path, String contents)
+{
+    auto file = open_file_for_writing(path).unwrap("Failed to create a benchmark file");
+    assert(write(file, contents.data, contents.size) == (s64)contents.size, "Failed to write a benchmark file");
+    close(file);
+}
+
+u64 count_bitmap_font_codepoints(BitmapFont* font)
+{
+    u64 result = 0;
+    for (u32 codepoint = 0; codepoint < 0x3000; codepoint++)
+    {
+        result += font->glyph_offsets.get(codepoint) != nullptr;
+    }
+    return result;
+}
+
+// nothing ships a font to test with, so a tiny PSF2 and a tiny BDF are written out and loaded back
+void check_bitmap_fonts()
+{
+    auto contents = String::allocate();
+    Psf2Header header;
+    header.magic = PSF2_MAGIC;
+    header.version = 0;
+    header.header_size = sizeof(Psf2Header);
+    header.flags = PSF2_FLAG_HAS_UNICODE_TABLE;
+    header.glyph_count = 2;
+    header.bytes_per_glyph = 16;
+    header.height = 16;
+    header.width = 8;
+    for (u64 i = 0; i < sizeof(header); i++)
+    {
+        contents.push(((char*)&header)[i]);
+    }
+    for (u64 i = 0; i < 16; i++)
+    {
+        contents.push(0xFF);
+    }
+    for (u64 i = 0; i < 16; i++)
+    {
+        contents.push(BENCHMARK_PSF2_GLYPH_ROW);
+    }
+    for (u64 i = 0; i + 1 < sizeof(BENCHMARK_PSF2_UNICODE_TABLE); i++)
+    {
+        contents.push(BENCHMARK_PSF2_UNICODE_TABLE[i]);
+    }
+    write_benchmark_file(BENCHMARK_PSF2_PATH, contents);
+    auto psf2 = BitmapFont::load(BENCHMARK_PSF2_PATH).unwrap("Failed to load the PSF2 font");
+    auto psf2_count = count_bitmap_font_codepoints(&psf2);
+    auto cyrillic = psf2.get_glyph(0x0416).unwrap("The PSF2 font has no Ж");
+    auto euro = psf2.get_glyph(0x20AC).unwrap("The PSF2 font has no €");
+    print("PSF2 font: ", psf2_count, " codepoints, ", psf2.glyph_width, "x", psf2.glyph_height, "\n");
+    assert(psf2_count == 4, "The PSF2 font should map 4 codepoints, not ", psf2_count);
+    assert(cyrillic.get_row(15) == (u64)BENCHMARK_PSF2_GLYPH_ROW << 56, "The PSF2 font's Ж has the wrong bitmap");
+    assert(euro.get_row(0) == (u64)0xFF << 56, "The PSF2 font's € has the wrong bitmap");
+    psf2.dispose();
+
+    contents.clear();
+    for (u64 i = 0; i + 1 < sizeof(BENCHMARK_BDF_TEXT); i++)
+    {
+        contents.push(BENCHMARK_BDF_TEXT[i]);
+    }
+    write_benchmark_file(BENCHMARK_BDF_PATH, contents);
+    auto bdf = BitmapFont::load(BENCHMARK_BDF_PATH).unwrap("Failed to load the BDF font");
+    auto bdf_count = count_bitmap_font_codepoints(&bdf);
+    auto bdf_euro = bdf.get_glyph(0x20AC).unwrap("The BDF font has no €");
+    print("BDF font: ", bdf_count, " codepoints, ", bdf.glyph_width, "x", bdf.glyph_height, "\n");
+    assert(bdf_count == 3, "The BDF font should index 3 codepoints, not ", bdf_count);
+    assert(bdf_euro.width == 6 && bdf_euro.height == 3 && bdf_euro.offset_x == 1 && bdf_euro.offset_y == 7, "The BDF font's € is misplaced");
+    assert(bdf_euro.get_row(1) == (u64)0x80 << 56, "The BDF font's € has the wrong bitmap");
+    assert(!bdf.get_glyph(0x20AD).has_data, "A BDF glyph offset past a u64 row should be rejected");
+
+    // into the built-in font's cell, shifted right by the BBX offset and down by the bounding boxes' difference
+    add_glyphs_from_font(&bdf, 0x20AC, 0x20AD);
+    auto euro_rows = extended_glyph_map.get(0x20AC);
+    assert(euro_rows != nullptr && euro_rows->rows[6] == 0 && euro_rows->rows[7] == 0x7C && euro_rows->rows[9] == 0x78, "The BDF font's € was added wrong");
+    assert(extended_glyph_map.get(0x20AD) == nullptr, "A rejected BDF glyph was added");
+
+    // A is 2 + 4 pixels, drawn at twice the size
+    auto image = Image::allocate(64, 64);
+    image.clear(WHITE);
+    String letter;
+    letter.data = (char*)"A";
+    letter.size = 1;
+    render_bitmap_font_text(&bdf, letter, BLACK, image, Vector2<u64>::construct(0, 0), 2);
+    ImageView view = image;
+    u64 black_count = 0;
+    for (u64 y = 0; y < view.height; y++)
+    {
+        for (u64 x = 0; x < view.width; x++)
+        {
+            black_count += view.get_row(y)[x] == BLACK;
+        }
+    }
+    assert(black_count == 6 * 4, "render_bitmap_font_text drew ", black_count, " pixels of A instead of 24");
+    image.deallocate();
+    bdf.dispose();
+
+    delete_file(BENCHMARK_PSF2_PATH);
+    delete_file(BENCHMARK_BDF_PATH);
+    contents.deallocate();
+}
+
+void benchmark_image_clear()
+{
+    u64 resolutions[][2] = {{256, 256}, {1024, 512}, {1920, 1080}, {3840, 2160}};
+    for (auto resolution : resolutions)
+    {
+        auto image = Image::allocate(resolution[0], resolution[1]);
+        auto pixel_count = image.width * image.height;
+        print(resolution[0], "x", resolution[1], " ");
+        run_benchmark("Image::clear", pixel_count, pixel_count * sizeof(Pixel), [&]() { image.clear(WHITE); });
+        image.deallocate();
+
+        auto paged_image = Image::allocate_in_pages(resolution[0], resolution[1]);
+        print(resolution[0], "x", resolution[1], " ", get_page_mode_name(paged_image.pages.mode), " ");
+        run_benchmark("Image::clear", pixel_count, pixel_count * sizeof(Pixel), [&]() { paged_image.clear(WHITE); });
+        paged_image.deallocate();
+    }
+}
+
+const u64 LINE_CHECK_COUNT = 2000;
+const u64 LINE_CHECK_IMAGE_SIZE = 64;
+
+u64 count_pixels(ImageView image, Pixel color, Vector2<u64> position, Vector2<u64> dimensions)
+{
+    u64 result = 0;
+    for (auto y = position.y; y < position.y + dimensions.y && y < image.height; y++)
+    {
+        for (auto x = position.x; x < position.x + dimensions.x && x < image.width; x++)
+        {
+            result += image.get_row(y)[x] == color;
+        }
+    }
+    return result;
+}
+
+u64 count_pixels(ImageView image, Pixel color)
+{
+    return count_pixels(image, color, Vector2<u64>::construct(0, 0), Vector2<u64>::construct(image.width, image.height));
+}
+
+// whether flipping the image left to right and top to bottom leaves it as it is, around the box at `position`
+bool is_box_symmetric(ImageView image, Vector2<u64> position, Vector2<u64> dimensions)
+{
+    for (u64 y = 0; y < dimensions.y; y++)
+    {
+        for (u64 x = 0; x < dimensions.x; x++)
+        {
+            auto pixel = image.get_row(position.y + y)[position.x + x];
+            auto is_mirrored_the_same = pixel == image.get_row(position.y + y)[position.x + dimensions.x - 1 - x]
+                && pixel == image.get_row(position.y + dimensions.y - 1 - y)[position.x + x];
+            if (!is_mirrored_the_same)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// lines between random points have both ends and exactly one pixel per step along their longer axis; thick lines
+// cover the expected rectangle, also when they're far longer than the image; boxes have the expected outlines
+void check_lines_and_boxes()
+{
+    u64 random_state = 0xDA942042E4DD58B5;
+    auto image = Image::allocate(LINE_CHECK_IMAGE_SIZE, LINE_CHECK_IMAGE_SIZE);
+    ImageView view = image;
+    u64 bad_line_count = 0;
+    for (u64 check_i = 0; check_i < LINE_CHECK_COUNT; check_i++)
+    {
+        view.clear(WHITE);
+        auto random_point = [&]()
+        {
+            return Vector2<u64>::construct(
+                get_next_benchmark_random(&random_state) % LINE_CHECK_IMAGE_SIZE,
+                get_next_benchmark_random(&random_state) % LINE_CHECK_IMAGE_SIZE
+            );
+        };
+        auto start = random_point();
+        auto end = random_point();
+        render_line(view, start, end, BLACK);
+        auto left = min(start.x, end.x);
+        auto top = min(start.y, end.y);
+        auto dimensions = Vector2<u64>::construct(max(start.x, end.x) - left + 1, max(start.y, end.y) - top + 1);
+        auto is_flat = dimensions.x >= dimensions.y;
+        auto step_count = is_flat ? dimensions.x : dimensions.y;
+        auto is_good = view.get_row(start.y)[start.x] == BLACK && view.get_row(end.y)[end.x] == BLACK
+            && count_pixels(view, BLACK) == step_count
+            && count_pixels(view, BLACK, Vector2<u64>::construct(left, top), dimensions) == step_count;
+        for (u64 step = 0; step < step_count && is_good; step++)
+        { // a column of the box for flat lines, a row for steep ones
+            auto step_position = is_flat ? Vector2<u64>::construct(left + step, top) : Vector2<u64>::construct(left, top + step);
+            auto step_dimensions = is_flat ? Vector2<u64>::construct(1, dimensions.y) : Vector2<u64>::construct(dimensions.x, 1);
+            is_good = count_pixels(view, BLACK, step_position, step_dimensions) == 1;
+        }
+        bad_line_count += !is_good;
+    }
+    print("render_line: ", LINE_CHECK_COUNT, " random lines, ", bad_line_count, " with missing ends or steps\n");
+    assert(bad_line_count == 0, "render_line drew a line with missing ends or steps");
+
+    // 8 wide around the row centers at 20.5: rows 16 to 23, from the start's pixel center to the end's
+    view.clear(WHITE);
+    render_thick_line(view, Vector2<u64>::construct(4, 20), Vector2<u64>::construct(59, 20), 8, BLACK);
+    auto short_count = count_pixels(view, BLACK, Vector2<u64>::construct(4, 16), Vector2<u64>::construct(55, 8));
+    assert(short_count == 55 * 8 && count_pixels(view, BLACK) == short_count, "render_thick_line missed its rectangle");
+    view.clear(WHITE);
+    render_thick_line(view, Vector2<u64>::construct(4, 20), Vector2<u64>::construct(100004, 20), 8, BLACK);
+    auto long_count = count_pixels(view, BLACK, Vector2<u64>::construct(4, 16), Vector2<u64>::construct(60, 8));
+    assert(long_count == 60 * 8 && count_pixels(view, BLACK) == long_count, "A long render_thick_line missed its rectangle");
+    // a long diagonal, cut by the image, covers what a short one does
+    view.clear(WHITE);
+    render_thick_line(view, Vector2<u64>::construct(0, 0), Vector2<u64>::construct(60000, 60000), 4, BLACK);
+    auto long_diagonal_count = count_pixels(view, BLACK);
+    render_thick_line(view, Vector2<u64>::construct(0, 0), Vector2<u64>::construct(600, 600), 4, WHITE);
+    auto uncovered_count = count_pixels(view, BLACK); // by the short one
+    view.clear(WHITE);
+    render_thick_line(view, Vector2<u64>::construct(0, 0), Vector2<u64>::construct(600, 600), 4, BLACK);
+    auto short_diagonal_count = count_pixels(view, BLACK);
+    print("render_thick_line: a 60000 pixel diagonal covers ", long_diagonal_count, " pixels, a 600 pixel one ", short_diagonal_count, ", ", uncovered_count, " of them not the same\n");
+    assert(short_diagonal_count > LINE_CHECK_IMAGE_SIZE * 4 && long_diagonal_count == short_diagonal_count && uncovered_count == 0, "A long render_thick_line doesn't cover what a short one does");
+
+    auto position = Vector2<u64>::construct(3, 5);
+    auto dimensions = Vector2<u64>::construct(40, 20);
+    view.clear(WHITE);
+    render_box(view, position, dimensions, 1, BLACK);
+    assert(count_pixels(view, BLACK) == (40 + 20) * 2 - 4 && count_pixels(view, BLACK, position, dimensions) == (40 + 20) * 2 - 4, "render_box drew the wrong outline");
+    view.clear(WHITE);
+    render_box(view, position, dimensions, 3, BLACK);
+    assert(count_pixels(view, BLACK) == 40 * 20 - 34 * 14 && count_pixels(view, WHITE, Vector2<u64>::construct(6, 8), Vector2<u64>::construct(34, 14)) == 34 * 14, "render_box drew the wrong thick outline");
+    view.clear(WHITE);
+    render_filled_rounded_box(view, position, dimensions, 6, BLACK);
+    assert(is_box_symmetric(view, position, dimensions) && count_pixels(view, BLACK) == count_pixels(view, BLACK, position, dimensions), "render_filled_rounded_box isn't symmetric in its box");
+    assert(view.get_row(5)[3] == WHITE && view.get_row(5)[9] == BLACK && count_pixels(view, BLACK, Vector2<u64>::construct(3, 15), Vector2<u64>::construct(40, 1)) == 40, "render_filled_rounded_box has the wrong corners");
+    auto filled_count = count_pixels(view, BLACK);
+    view.clear(WHITE);
+    render_rounded_box(view, position, dimensions, 6, 2, BLACK);
+    auto outline_count = count_pixels(view, BLACK);
+    assert(is_box_symmetric(view, position, dimensions) && view.get_row(5)[3] == WHITE && view.get_row(15)[20] == WHITE, "render_rounded_box isn't an outline in its box");
+    assert(outline_count < filled_count && count_pixels(view, BLACK, Vector2<u64>::construct(3, 15), Vector2<u64>::construct(40, 1)) == 4, "render_rounded_box has the wrong sides");
+    image.deallocate();
+}
+
+void benchmark_render_box()
+{
+    check_lines_and_boxes();
+    auto image = Image::allocate(WINDOW_WIDTH, WINDOW_HEIGHT);
+    image.clear(WHITE);
+    auto position = Vector2<u64>::construct(100, 100);
+    auto dimensions = Vector2<u64>::construct(200, 40);
+    auto outline_pixel_count = (dimensions.x + dimensions.y) * 2;
+    run_benchmark("render_box 200x40", outline_pixel_count, outline_pixel_count * sizeof(Pixel), [&]()
+    {
+        render_box(image, position, dimensions, 1, BLACK);
+    });
+    auto box_pixel_count = dimensions.x * dimensions.y;
+    run_benchmark("render_filled_rounded_box 200x40", box_pixel_count, box_pixel_count * sizeof(Pixel), [&]()
+    {
+        render_filled_rounded_box(image, position, dimensions, 10, BLACK);
+    });
+    image.deallocate();
+}
+
+void benchmark_render_line()
+{
+    auto image = Image::allocate(WINDOW_WIDTH, WINDOW_HEIGHT);
+    image.clear(WHITE);
+    // mostly horizontal, mostly vertical, and thick
+    auto start = Vector2<u64>::construct(10, 10);
+    auto flat_end = Vector2<u64>::construct(WINDOW_WIDTH - 10, 60);
+    auto steep_end = Vector2<u64>::construct(60, WINDOW_HEIGHT - 10);
+    run_benchmark("render_line flat", flat_end.x - start.x, 0, [&]() { render_line(image, start, flat_end, BLACK); });
+    run_benchmark("render_line steep", steep_end.y - start.y, 0, [&]() { render_line(image, start, steep_end, BLACK); });
+    run_benchmark("render_thick_line 8 wide", (flat_end.x - start.x) * 8, 0, [&]() { render_thick_line(image, start, flat_end, 8, BLACK); });
+    image.deallocate();
+}
+
+const u64 BLIT_CHECK_COUNT = 3000;
+const u64 BLIT_CHECK_IMAGE_SIZE = 24;
+
+enum BlitCheckKind : u8
+{
+    BlitCheckKindCopy,
+    BlitCheckKindColorKeyed,
+    BlitCheckKindBlended,
+};
+
+// blend_pixel a channel at a time: x / 255 rounded down, the source's alpha counts as 255 for the alpha channel
+Pixel blend_pixel_per_channel(Pixel destination, Pixel source)
+{
+    u32 alpha = source >> 24;
+    Pixel result = 0;
+    for (u64 shift = 0; shift < 32; shift += 8)
+    {
+        u32 source_channel = shift == 24 ? 0xFF : (source >> shift) & 0xFF;
+        u32 destination_channel = (destination >> shift) & 0xFF;
+        result |= (source_channel * alpha + destination_channel * (0xFF - alpha)) / 0xFF << shift;
+    }
+    return result;
+}
+
+// the blits of random rectangles to random places through random clips, half of them within one image, against
+// a pixel-by-pixel reference that reads from a copy of the images taken before the blit
+void check_blits()
+{
+    u64 random_state = 0x853C49E6748FEA9B;
+    auto source = Image::allocate(BLIT_CHECK_IMAGE_SIZE, BLIT_CHECK_IMAGE_SIZE);
+    auto destination = Image::allocate(BLIT_CHECK_IMAGE_SIZE, BLIT_CHECK_IMAGE_SIZE);
+    auto source_before = Image::allocate(BLIT_CHECK_IMAGE_SIZE, BLIT_CHECK_IMAGE_SIZE);
+    auto destination_before = Image::allocate(BLIT_CHECK_IMAGE_SIZE, BLIT_CHECK_IMAGE_SIZE);
+    Pixel key = 0x00123456;
+    u64 mismatch_count = 0;
+    u64 blitted_pixel_count = 0;
+    for (u64 check_i = 0; check_i < BLIT_CHECK_COUNT; check_i++)
+    {
+        ImageView source_view = source;
+        ImageView destination_view = destination;
+        ImageView source_before_view = source_before;
+        ImageView destination_before_view = destination_before;
+        for (u64 y = 0; y < BLIT_CHECK_IMAGE_SIZE; y++)
+        {
+            for (u64 x = 0; x < BLIT_CHECK_IMAGE_SIZE; x++)
+            { // opaque, transparent, in between, and the key
+                auto random = get_next_benchmark_random(&random_state);
+                Pixel alpha = (random >> 32) % 4 == 0 ? 0xFF : (random >> 32) % 4 == 1 ? 0 : random >> 40;
+                source_view.get_row(y)[x] = (random >> 34) % 5 == 0 ? key : (Pixel)(alpha << 24 | (random & 0xFFFFFF));
+                destination_view.get_row(y)[x] = get_next_benchmark_random(&random_state);
+            }
+        }
+        auto is_within_one_image = get_next_benchmark_random(&random_state) % 2 == 0;
+        if (is_within_one_image)
+        {
+            source_view = destination_view;
+        }
+        for (u64 y = 0; y < BLIT_CHECK_IMAGE_SIZE; y++)
+        {
+            for (u64 x = 0; x < BLIT_CHECK_IMAGE_SIZE; x++)
+            {
+                source_before_view.get_row(y)[x] = source_view.get_row(y)[x];
+                destination_before_view.get_row(y)[x] = destination_view.get_row(y)[x];
+            }
+        }
+
+        // positions mostly inside, sizes up to past the edges
+        auto random_position = [&]() { return get_next_benchmark_random(&random_state) % (BLIT_CHECK_IMAGE_SIZE + 4) / 2; };
+        auto random_size = [&]() { return get_next_benchmark_random(&random_state) % (BLIT_CHECK_IMAGE_SIZE + 4); };
+        auto position = Vector2<u64>::construct(random_position(), random_position());
+        auto source_rectangle = Rectangle::construct(
+            Vector2<u64>::construct(random_position(), random_position()),
+            Vector2<u64>::construct(random_size(), random_size())
+        );
+        auto clip = Rectangle::construct(
+            Vector2<u64>::construct(random_position(), random_position()),
+            Vector2<u64>::construct(random_size(), random_size())
+        );
+        auto kind = (BlitCheckKind)(get_next_benchmark_random(&random_state) % 3);
+        switch (kind)
+        {
+            case BlitCheckKindCopy: blit(destination_view, position, source_view, source_rectangle, clip); break;
+            case BlitCheckKindColorKeyed: blit_color_keyed(destination_view, position, source_view, source_rectangle, key, clip); break;
+            case BlitCheckKindBlended: blit_blended(destination_view, position, source_view, source_rectangle, clip); break;
+        }
+
+        for (u64 y = 0; y < BLIT_CHECK_IMAGE_SIZE; y++)
+        {
+            for (u64 x = 0; x < BLIT_CHECK_IMAGE_SIZE; x++)
+            {
+                auto expected = destination_before_view.get_row(y)[x];
+                auto source_x = source_rectangle.position.x + x - position.x;
+                auto source_y = source_rectangle.position.y + y - position.y;
+                auto is_blitted = x >= position.x && y >= position.y
+                    && x >= clip.position.x && x < clip.position.x + clip.dimensions.x
+                    && y >= clip.position.y && y < clip.position.y + clip.dimensions.y
+                    && source_x < source_rectangle.position.x + source_rectangle.dimensions.x && source_x < BLIT_CHECK_IMAGE_SIZE
+                    && source_y < source_rectangle.position.y + source_rectangle.dimensions.y && source_y < BLIT_CHECK_IMAGE_SIZE;
+                if (is_blitted)
+                {
+                    auto source_pixel = source_before_view.get_row(source_y)[source_x];
+                    blitted_pixel_count++;
+                    switch (kind)
+                    {
+                        case BlitCheckKindCopy: expected = source_pixel; break;
+                        case BlitCheckKindColorKeyed: expected = source_pixel == key ? expected : source_pixel; break;
+                        case BlitCheckKindBlended: expected = blend_pixel_per_channel(expected, source_pixel); break;
+                    }
+                }
+                mismatch_count += destination_view.get_row(y)[x] != expected;
+            }
+        }
+    }
+    print("blits against the per-pixel reference: ", BLIT_CHECK_COUNT, " random blits, ", blitted_pixel_count, " pixels blitted, ", mismatch_count, " mismatches\n");
+    assert(mismatch_count == 0, "A blit disagrees with the per-pixel reference");
+    destination_before.deallocate();
+    source_before.deallocate();
+    destination.deallocate();
+    source.deallocate();
+}
+
+void benchmark_blit()
+{
+    check_blits();
+    auto destination = Image::allocate(1920, 1080);
+    auto source = Image::allocate(1920, 1080);
+    destination.clear(WHITE);
+    source.clear(0x80000000);
+    auto pixel_count = source.width * source.height;
+    auto whole = Rectangle::construct(Vector2<u64>::construct(0, 0), Vector2<u64>::construct(source.width, source.height));
+    print("1920x1080 ");
+    run_benchmark("blit", pixel_count, pixel_count * sizeof(Pixel), [&]() { blit(destination, Vector2<u64>::construct(0, 0), source, whole); });
+    print("1920x1080 ");
+    run_benchmark("blit_color_keyed", pixel_count, pixel_count * sizeof(Pixel), [&]()
+    {
+        blit_color_keyed(destination, Vector2<u64>::construct(0, 0), source, whole, WHITE);
+    });
+    print("1920x1080 ");
+    run_benchmark("blit_blended", pixel_count, pixel_count * sizeof(Pixel), [&]()
+    {
+        blit_blended(destination, Vector2<u64>::construct(0, 0), source, whole);
+    });
+    // scrolling the image by a row onto itself, which has to copy backwards
+    auto scrolled = Rectangle::construct(Vector2<u64>::construct(0, 0), Vector2<u64>::construct(source.width, source.height - 1));
+    print("1920x1079 ");
+    run_benchmark("blit overlapping", pixel_count, pixel_count * sizeof(Pixel), [&]() { blit(destination, Vector2<u64>::construct(0, 1), destination, scrolled); });
+    source.deallocate();
+    destination.deallocate();
+}
+
+const u64 PATH_ROW_CHECK_COUNT = 20000;
+const u64 PATH_ROW_CHECK_MAX_CELLS = 70;
+
+// the AVX2 coverage of a row's cells against the scalar one, for random rows whose covers wind up to a few times
+// either way, under both fill rules
+void check_path_row_resolve()
+{
+    if (!is_avx2_available())
+    {
+        print("AVX2 isn't available, the scalar path row resolve is the only one\n");
+        return;
+    }
+    u64 random_state = 0xDA942042E4DD58B5;
+    s32 covers[PATH_ROW_CHECK_MAX_CELLS + 7];
+    s32 areas[PATH_ROW_CHECK_MAX_CELLS + 7];
+    u32 expected_cells[PATH_ROW_CHECK_MAX_CELLS];
+    u32 expected_spans[PATH_ROW_CHECK_MAX_CELLS];
+    u32 cells[PATH_ROW_CHECK_MAX_CELLS + 7];
+    u32 spans[PATH_ROW_CHECK_MAX_CELLS + 7];
+    u64 mismatch_count = 0;
+    u64 cell_count = 0;
+    for (u64 check_i = 0; check_i < PATH_ROW_CHECK_COUNT; check_i++)
+    {
+        auto count = get_next_benchmark_random(&random_state) % (PATH_ROW_CHECK_MAX_CELLS + 1);
+        auto rounded_count = (count + 7) & ~(u64)7;
+        for (u64 i = 0; i < rounded_count; i++)
+        {
+            s32 cover = i < count ? (s32)(get_next_benchmark_random(&random_state) % (4 * PATH_ONE + 1)) - 2 * PATH_ONE : 0;
+            covers[i] = cover;
+            areas[i] = cover * (s32)(get_next_benchmark_random(&random_state) % (2 * PATH_ONE + 1));
+        }
+        auto rule = check_i % 2 == 0 ? PathFillRuleNonZero : PathFillRuleEvenOdd;
+        resolve_path_row_scalar(covers, areas, count, rule, expected_cells, expected_spans);
+        resolve_path_row_avx2(covers, areas, rounded_count, rule, cells, spans);
+        for (u64 i = 0; i < count; i++)
+        {
+            mismatch_count += cells[i] != expected_cells[i] || spans[i] != expected_spans[i];
+        }
+        cell_count += count;
+    }
+    print("AVX2 path row resolve against the scalar one: ", PATH_ROW_CHECK_COUNT, " random rows, ", cell_count, " cells, ", mismatch_count, " mismatches\n");
+    assert(mismatch_count == 0, "The AVX2 path row resolve disagrees with the scalar one");
+}
+
+// a line chart: a random walk of `segment_count` strokes across the whole image, and a filled curvy blob
+void benchmark_path_rasterizer()
+{
+    check_path_row_resolve();
+    auto image = Image::allocate(1920, 1080);
+    image.clear(WHITE);
+    auto scratch = Arena::allocate(FRAME_ARENA_SIZE);
+    auto rasterizer = PathRasterizer::allocate();
+    u64 segment_counts[] = {100, 1500, 2000, 5000}; // about 1500 fit into a millisecond
+    for (auto segment_count : segment_counts)
+    {
+        print(segment_count, " segments ");
+        run_benchmark("PathRasterizer chart", 0, 0, [&]()
+        {
+            scratch.reset();
+            rasterizer.begin(image);
+            auto previous = Vector2<s64>::construct(0, 540 * PATH_ONE);
+            for (u64 i = 1; i <= segment_count; i++)
+            {
+                // steps of up to 8 pixels either way
+                auto step = (s64)(i * 7919 % 4097) - 2048;
+                auto point = Vector2<s64>::construct(i * 1920 * PATH_ONE / segment_count, previous.y + step);
+                rasterizer.stroke_line(previous, point, PATH_ONE * 3 / 2);
+                previous = point;
+            }
+            rasterizer.fill(BLACK, PathFillRuleNonZero, &scratch);
+        });
+    }
+    print("400x400 ");
+    run_benchmark("PathRasterizer blob", 400 * 400, 0, [&]()
+    {
+        scratch.reset();
+        rasterizer.begin(image);
+        rasterizer.move_to(Vector2<s64>::construct(100 * PATH_ONE, 300 * PATH_ONE));
+        rasterizer.quadratic_to(Vector2<s64>::construct(300 * PATH_ONE, 0), Vector2<s64>::construct(500 * PATH_ONE, 300 * PATH_ONE));
+        rasterizer.cubic_to(
+            Vector2<s64>::construct(550 * PATH_ONE, 600 * PATH_ONE),
+            Vector2<s64>::construct(50 * PATH_ONE, 600 * PATH_ONE),
+            Vector2<s64>::construct(100 * PATH_ONE, 300 * PATH_ONE)
+        );
+        rasterizer.fill(BLACK, PathFillRuleEvenOdd, &scratch);
+    });
+    rasterizer.deallocate();
+    scratch.deallocate();
+    image.deallocate();
+}
+
+void benchmark_render_text()
+{
+    auto image = Image::allocate(WINDOW_WIDTH, WINDOW_HEIGHT);
+    image.clear(WHITE);
+    u64 font_sizes[] = {8, 16, 32, 64};
+    u64 text_sizes[] = {16, 256};
+    for (auto font_size : font_sizes)
+    {
+        for (auto text_size : text_sizes)
+        {
+            auto text = get_benchmark_text(text_size);
+            auto text_box = measure_text(text, font_size, image.width);
+            print("size ", font_size, ", ", text.size, " bytes ");
+            run_benchmark("render_text", text_box.x * text_box.y, text.size, [&]()
+            {
+                render_text(text, BLACK, image, Vector2<u64>::construct(0, 0), font_size);
+            });
+        }
+    }
+    image.deallocate();
+}
+
+void benchmark_render_input()
+{
+    auto image = Image::allocate(WINDOW_WIDTH, WINDOW_HEIGHT);
+    auto events = List<X11Event>::allocate();
+    u64 text_sizes[] = {0, 16, 256, 4096, 1024 * 1024}; // only what's scrolled into view gets drawn, whatever the size
+    for (auto text_size : text_sizes)
+    {
+        auto state = InputState::construct(Vector2<u64>::construct(100, 100), Vector2<u64>::construct(200, 40), 32);
+        for (u64 i = 0; i < text_size; i++)
+        {
+            state.insert(BENCHMARK_TEXT[i % (sizeof(BENCHMARK_TEXT) - 1)]);
+        }
+        state.is_layout_dirty = true;
+        print(text_size, " bytes ");
+        run_benchmark("render_input", state.dimensions.x * state.dimensions.y, 0, [&]() { render_input(&state, events, image); });
+        state.text.deallocate();
+    }
+    events.deallocate();
+    image.deallocate();
+}
+
+// clicks among a form of 100x100 small inputs, each one is a grid cell lookup and a few rectangle tests
+void benchmark_widget_hit_test()
+{
+    auto widgets = InputWidgets::allocate();
+    for (u64 y = 0; y < 100; y++)
+    {
+        for (u64 x = 0; x < 100; x++)
+        {
+            widgets.add(InputState::construct(Vector2<u64>::construct(x * 50, y * 30), Vector2<u64>::construct(45, 25), 8));
+        }
+    }
+    widgets.grid.build(widgets.inputs);
+    u64 click_index = 0;
+    u64 hit_count = 0;
+    print(widgets.inputs.size, " inputs ");
+    run_benchmark("WidgetGrid::find", 0, 0, [&]()
+    {
+        click_index++;
+        auto point = Vector2<u64>::construct(click_index * 7919 % 5000, click_index * 104729 % 3000);
+        hit_count += widgets.grid.find(widgets.inputs, point).has_data;
+    });
+    print("(", hit_count, " hits)\n");
+    widgets.deallocate();
+}
+
+// the reference TextSearch has to agree with: every offset compared in full
+void search_naively(byte* data, u64 size, String needle, List<u64>* matches)
+{
+    for (u64 i = 0; i + needle.size <= size; i++)
+    {
+        if (are_bytes_equal(data + i, (byte*)needle.data, needle.size))
+        {
+            matches->push(i);
+        }
+    }
+}
+
+const u64 TEXT_SEARCH_CHECK_COUNT = 2000;
+const u64 TEXT_SEARCH_BENCHMARK_SIZE = 64 * 1024 * 1024;
+
+// first checks TextSearch against the naive search on random texts over a tiny alphabet, so matches overlap and
+// straddle the split between the two parts and there are more than the search keeps, then times both over a big text
+void benchmark_text_search()
+{
+    u64 random_state = 0x9E3779B97F4A7C15;
+    auto text = String::allocate();
+    auto needle = String::allocate();
+    auto expected = List<u64>::allocate();
+    u64 mismatch_count = 0;
+    u64 match_count = 0;
+    for (u64 check_i = 0; check_i < TEXT_SEARCH_CHECK_COUNT; check_i++)
+    {
+        text.clear();
+        needle.clear();
+        expected.clear();
+        auto text_size = get_next_benchmark_random(&random_state) % 300;
+        for (u64 i = 0; i < text_size; i++)
+        {
+            text.push("ab\n"[get_next_benchmark_random(&random_state) % 3]);
+        }
+        auto needle_size = 1 + get_next_benchmark_random(&random_state) % 6;
+        for (u64 i = 0; i < needle_size; i++)
+        {
+            needle.push("ab\n"[get_next_benchmark_random(&random_state) % 3]);
+        }
+        auto split = text_size != 0 ? get_next_benchmark_random(&random_state) % (text_size + 1) : 0;
+        auto needle_split = get_next_benchmark_random(&random_state) % (needle_size + 1);
+        String needle_before;
+        needle_before.data = needle.data;
+        needle_before.size = needle_split;
+        String needle_after;
+        needle_after.data = needle.data + needle_split;
+        needle_after.size = needle_size - needle_split;
+        auto max_match_count = 1 + get_next_benchmark_random(&random_state) % 100;
+        search_naively((byte*)text.data, text.size, needle, &expected);
+        expected.size = min(expected.size, max_match_count);
+        auto search = TextSearch::start(
+            (byte*)text.data, split, (byte*)text.data + split, text_size - split, needle_before, needle_after, max_match_count
+        );
+        while (!search.run_slice())
+        {
+        }
+        mismatch_count += search.matches.size != expected.size
+            || !are_bytes_equal((byte*)search.matches.data, (byte*)expected.data, expected.size * sizeof(u64));
+        match_count += expected.size;
+        search.deallocate();
+    }
+    print("TextSearch against the naive search: ", TEXT_SEARCH_CHECK_COUNT, " random texts, ", match_count, " matches, ", mismatch_count, " mismatches\n");
+    assert(mismatch_count == 0, "TextSearch disagrees with the naive search");
+
+    text.clear();
+    for (u64 i = 0; i < TEXT_SEARCH_BENCHMARK_SIZE; i++)
+    {
+        text.push(BENCHMARK_TEXT[i % (sizeof(BENCHMARK_TEXT) - 1)]);
+    }
+    CStringView needles[] = {"z", "quartz", "sphinx of black"};
+    for (auto needle_text : needles)
+    {
+        needle.clear();
+        for (u64 i = 0; needle_text[i] != 0; i++)
+        {
+            needle.push(needle_text[i]);
+        }
+        print(TEXT_SEARCH_BENCHMARK_SIZE / (1024 * 1024), " MB for \"", needle_text, "\" ");
+        run_benchmark("TextSearch", 0, text.size, [&]()
+        {
+            auto search = TextSearch::start((byte*)text.data, text.size, needle, /* max_match_count: */ text.size);
+            while (!search.run_slice())
+            {
+            }
+            search.deallocate();
+        });
+        print(TEXT_SEARCH_BENCHMARK_SIZE / (1024 * 1024), " MB for \"", needle_text, "\" ");
+        run_benchmark("naive search", 0, text.size, [&]()
+        {
+            expected.clear();
+            search_naively((byte*)text.data, text.size, needle, &expected);
+        });
+    }
+    expected.deallocate();
+    needle.deallocate();
+    text.deallocate();
+}
+
+const u64 UTF8_CHECK_COUNT = 20000;
+const u64 UTF8_BENCHMARK_SIZE = 64 * 1024 * 1024;
+
+// sequences at the edges of what's valid, and bytes that break whatever they land in
+CStringView UTF8_CHECK_PIECES[] = {
+    "a", "\n", "\x7F", "The quick brown fox jumps over the lazy dog. ", "\xC2\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xED\x9F\xBF", "\xEE\x80\x80", "\xEF\xBF\xBF",
+    "\xF0\x90\x80\x80", "\xF4\x8F\xBF\xBF", "\xE2\x82\xAC", "\xF0\x9F\x93\x8B",
+};
+CStringView UTF8_CHECK_BREAKERS[] = {
+    "\x80", "\xBF", "\xC0\x80", "\xC1\xBF", "\xE0\x9F\xBF", "\xED\xA0\x80", "\xF0\x8F\xBF\xBF", "\xF4\x90\x80\x80",
+    "\xF5\x80\x80\x80", "\xF8", "\xFF", "\xC2", "\xE2\x82", "\xF0\x9F\x93",
+};
+
+// first checks find_invalid_utf8 against find_invalid_utf8_scalar on random texts that mostly are valid, so the
+// AVX2 validator gets through a few blocks before the error, then times both over ASCII and over 3-byte text
+void benchmark_utf8_validation()
+{
+    print("AVX2 ", is_avx2_available() ? "is" : "isn't", " available\n");
+    u64 random_state = 0x2545F4914F6CDD1D;
+    auto text = String::allocate();
+    u64 mismatch_count = 0;
+    u64 valid_count = 0;
+    for (u64 check_i = 0; check_i < UTF8_CHECK_COUNT; check_i++)
+    {
+        text.clear();
+        auto piece_count = get_next_benchmark_random(&random_state) % 100;
+        auto breaker_chance = 1 + get_next_benchmark_random(&random_state) % 200;
+        for (u64 piece_i = 0; piece_i < piece_count; piece_i++)
+        {
+            auto random = get_next_benchmark_random(&random_state);
+            auto piece = random % breaker_chance == 0
+                ? UTF8_CHECK_BREAKERS[random / breaker_chance % (sizeof(UTF8_CHECK_BREAKERS) / sizeof(UTF8_CHECK_BREAKERS[0]))]
+                : UTF8_CHECK_PIECES[random / breaker_chance % (sizeof(UTF8_CHECK_PIECES) / sizeof(UTF8_CHECK_PIECES[0]))];
+            for (u64 i = 0; piece[i] != 0; i++)
+            {
+                text.push(piece[i]);
+            }
+        }
+        auto expected = find_invalid_utf8_scalar((byte*)text.data, text.size);
+        mismatch_count += find_invalid_utf8((byte*)text.data, text.size) != expected;
+        valid_count += expected == text.size;
+    }
+    print("find_invalid_utf8 against the scalar validator: ", UTF8_CHECK_COUNT, " random texts, ", valid_count, " valid, ", mismatch_count, " mismatches\n");
+    assert(mismatch_count == 0, "find_invalid_utf8 disagrees with the scalar validator");
+
+    CStringView repeated_texts[] = {"The quick brown fox jumps over the lazy dog. ", "\xE6\x96\x87\xE5\xAD\x97\xE2\x82\xAC"};
+    CStringView text_names[] = {"ASCII", "3-byte"};
+    for (u64 text_i = 0; text_i < sizeof(repeated_texts) / sizeof(repeated_texts[0]); text_i++)
+    {
+        auto repeated = repeated_texts[text_i];
+        auto repeated_size = get_c_string_length(repeated);
+        text.clear();
+        for (u64 i = 0; i + repeated_size <= UTF8_BENCHMARK_SIZE; i += repeated_size)
+        {
+            for (u64 j = 0; j < repeated_size; j++)
+            {
+                text.push(repeated[j]);
+            }
+        }
+        // starting a different sequence in each time, so the call can't be hoisted out of the benchmark's loop
+        u64 run_i = 0;
+        u64 invalid_offset = 0;
+        print(UTF8_BENCHMARK_SIZE / (1024 * 1024), " MB of ", text_names[text_i], " ");
+        run_benchmark("find_invalid_utf8", 0, text.size, [&]()
+        {
+            auto start = run_i++ % 8 * repeated_size;
+            invalid_offset += start + find_invalid_utf8((byte*)text.data + start, text.size - start);
+        });
+        print(UTF8_BENCHMARK_SIZE / (1024 * 1024), " MB of ", text_names[text_i], " ");
+        run_benchmark("find_invalid_utf8_scalar", 0, text.size, [&]()
+        {
+            auto start = run_i++ % 8 * repeated_size;
+            invalid_offset += start + find_invalid_utf8_scalar((byte*)text.data + start, text.size - start);
+        });
+        assert(invalid_offset % text.size == 0, "the benchmark text isn't valid");
+    }
+    text.deallocate();
+}
+
+CStringView BENCHMARK_DOCUMENT_PATH = "/tmp/benchmark_document.txt";
+const u64 BENCHMARK_DOCUMENT_SIZE = 256 * 1024 * 1024;
+const u64 BENCHMARK_DOCUMENT_LONG_LINE_SIZE = 32 * 1024 * 1024; // in the middle of the file, without a line break
+
+// lines of BENCHMARK_TEXT prefixes, and one huge line halfway through; returns the long line's number
+u64 write_benchmark_document()
+{
+    auto file = open_file_for_writing(BENCHMARK_DOCUMENT_PATH).unwrap("Failed to create the benchmark document");
+    auto buffer = String::allocate();
+    u64 written_size = 0;
+    u64 line_count = 0;
+    u64 long_line = 0;
+    while (written_size < BENCHMARK_DOCUMENT_SIZE)
+    {
+        buffer.clear();
+        if (long_line == 0 && written_size >= BENCHMARK_DOCUMENT_SIZE / 2)
+        {
+            for (u64 i = 0; i < BENCHMARK_DOCUMENT_LONG_LINE_SIZE; i++)
+            {
+                buffer.push(BENCHMARK_TEXT[i % (sizeof(BENCHMARK_TEXT) - 1)]);
+            }
+            buffer.push('\n');
+            long_line = line_count++;
+        }
+        while (buffer.size < 1024 * 1024)
+        {
+            auto line = get_benchmark_text(line_count * 37 % sizeof(BENCHMARK_TEXT));
+            for (u64 i = 0; i < line.size; i++)
+            {
+                buffer.push(line.data[i]);
+            }
+            buffer.push('\n');
+            line_count++;
+        }
+        assert(write(file, buffer.data, buffer.size) == (s64)buffer.size, "Failed to write the benchmark document");
+        written_size += buffer.size;
+    }
+    close(file);
+    buffer.deallocate();
+    return long_line;
+}
+
+// a mapped file much bigger than a frame's worth of work: opening it and drawing the first frame, indexing it
+// all, and drawing and scrolling around a line too long to ever be scanned in a frame
+void benchmark_document_view()
+{
+    auto long_line = write_benchmark_document();
+    auto image = Image::allocate(WINDOW_WIDTH, WINDOW_HEIGHT);
+    auto position = Vector2<u64>::construct(DOCUMENT_X, DOCUMENT_Y);
+    auto dimensions = get_document_dimensions(image.width, image.height);
+    auto open_and_render = [&]()
+    {
+        auto document = DocumentView::open(BENCHMARK_DOCUMENT_PATH, DOCUMENT_FONT_SIZE).unwrap("Failed to open the benchmark document");
+        document.update();
+        document.render(image, position, dimensions);
+        document.dispose();
+    };
+    print(BENCHMARK_DOCUMENT_SIZE / (1024 * 1024), " MB ");
+    run_benchmark("DocumentView open and first frame", dimensions.x * dimensions.y, 0, open_and_render);
+
+    auto document = DocumentView::open(BENCHMARK_DOCUMENT_PATH, DOCUMENT_FONT_SIZE).unwrap("Failed to open the benchmark document");
+    auto index_start = get_monotonic_time();
+    while (!document.is_indexing_done())
+    {
+        document.index_next_chunk();
+    }
+    auto index_time = get_monotonic_time() - index_start;
+    print("DocumentView indexing: ", index_time / 1000, " us, ", document.indexed_line_count, " lines, ");
+    print_fixed(document.file.size * 1000 * 100 / index_time, 2);
+    print(" MB/s\n");
+
+    document.first_visible_line = 0;
+    run_benchmark("DocumentView::render top", dimensions.x * dimensions.y, 0, [&]() { document.render(image, position, dimensions); });
+    document.first_visible_line = long_line;
+    run_benchmark("DocumentView::render long line", dimensions.x * dimensions.y, 0, [&]() { document.render(image, position, dimensions); });
+    document.first_visible_line = long_line - 10;
+    s64 direction = 1;
+    run_benchmark("DocumentView scroll a line around the long line", dimensions.x * dimensions.y, 0, [&]()
+    {
+        document.scroll_by(direction);
+        direction = -direction;
+        document.render(image, position, dimensions);
+    });
+
+    document.dispose();
+    image.deallocate();
+    delete_file(BENCHMARK_DOCUMENT_PATH);
+}
+
+// the server side of the socket is drained by a child process, so the upload runs at the speed of the kernel's
+// socket buffers and the request encoding, without a real server
+void benchmark_put_image_in_chunks()
+{
+    Descriptor client_socket;
+    Descriptor sink_socket;
+    assert(create_socket_pair(&client_socket, &sink_socket), "Failed to create a socket pair");
+    auto pid = fork_process();
+    assert(pid >= 0, "Failed to fork the socket sink");
+    if (pid == 0)
+    {
+        close(client_socket);
+        byte buffer[64 * 1024];
+        while (read(sink_socket, buffer, sizeof(buffer)) > 0)
+        {
+        }
+        exit(0);
+    }
+    close(sink_socket);
+
+    auto connection = X11Connection::construct(client_socket, 0, 0, 0);
+    X11Window window;
+    window.id = 1;
+    window.gc_id = 2;
+    auto image = Image::allocate(WINDOW_WIDTH, WINDOW_HEIGHT);
+    image.clear(WHITE);
+    auto pixel_count = image.width * image.height;
+    print(WINDOW_WIDTH, "x", WINDOW_HEIGHT, " ");
+    run_benchmark("put_image_in_chunks", pixel_count, pixel_count * sizeof(Pixel), [&]()
+    {
+        put_image_in_chunks(&connection, window, image);
+        connection.flush();
+    });
+    image.deallocate();
+    connection.dispose();
+}
+
+extern "C" void _start()
+{
+    check_bitmap_fonts();
+    benchmark_image_clear();
+    benchmark_render_box();
+    benchmark_render_line();
+    benchmark_blit();
+    benchmark_path_rasterizer();
+    benchmark_render_text();
+    benchmark_render_input();
+    benchmark_widget_hit_test();
+    benchmark_text_search();
+    benchmark_utf8_validation();
+    benchmark_document_view();
+    benchmark_put_image_in_chunks();
+    exit(0);
+}
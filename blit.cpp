@@ -0,0 +1,186 @@
+// copying and compositing rectangles of pixels from one image or view into another, row by row; copies move a
+// PixelPair at a time, and blending multiplies two channels at once, red with blue and alpha with green
+
+// the parts of the source and the destination that a blit actually touches, both the same size
+struct BlitViews
+{
+    ImageView destination;
+    ImageView source;
+
+    // views of one image where the destination starts inside the source get walked from the end, like memmove
+    bool is_backward()
+    {
+        if (source.height == 0 || source.width == 0)
+        {
+            return false;
+        }
+        auto source_end = source.get_row(source.height - 1) + source.width;
+        return destination.data > source.data && destination.data < source_end;
+    }
+};
+
+// `source_rectangle` of `source` goes to `destination_position`, minus whatever falls outside either view or
+// outside `clip`, which is in destination coordinates
+BlitViews clip_blit(ImageView destination, Vector2<u64> destination_position, ImageView source, Rectangle source_rectangle, Rectangle clip)
+{
+    auto source_view = source.get_sub_view(source_rectangle.position, source_rectangle.dimensions);
+    auto left = max(destination_position.x, clip.position.x);
+    auto top = max(destination_position.y, clip.position.y);
+    auto right = min(min(destination_position.x + source_view.width, clip.position.x + clip.dimensions.x), destination.width);
+    auto bottom = min(min(destination_position.y + source_view.height, clip.position.y + clip.dimensions.y), destination.height);
+    auto dimensions = Vector2<u64>::construct(right > left ? right - left : 0, bottom > top ? bottom - top : 0);
+
+    BlitViews result;
+    result.destination = destination.get_sub_view(Vector2<u64>::construct(left, top), dimensions);
+    result.source = source_view.get_sub_view(Vector2<u64>::construct(left - destination_position.x, top - destination_position.y), dimensions);
+    return result;
+}
+
+Rectangle get_whole_view_rectangle(ImageView image)
+{
+    return Rectangle::construct(Vector2<u64>::construct(0, 0), Vector2<u64>::construct(image.width, image.height));
+}
+
+void copy_pixels_forward(Pixel* destination, Pixel* source, u64 count)
+{
+    u64 i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        *(PixelPair*)(destination + i) = *(PixelPair*)(source + i);
+    }
+    if (i < count)
+    {
+        destination[i] = source[i];
+    }
+}
+
+void copy_pixels_backward(Pixel* destination, Pixel* source, u64 count)
+{
+    auto i = count;
+    for (; i >= 2; i -= 2)
+    {
+        *(PixelPair*)(destination + i - 2) = *(PixelPair*)(source + i - 2);
+    }
+    if (i != 0)
+    {
+        destination[0] = source[0];
+    }
+}
+
+// calls `operation(destination_pixel, source_pixel)` for every pixel of the blit, in a safe order for overlaps
+template <typename PixelOperation>
+void for_each_blit_pixel(BlitViews views, PixelOperation operation)
+{
+    if (!views.is_backward())
+    {
+        for (u64 y = 0; y < views.destination.height; y++)
+        {
+            auto destination_row = views.destination.get_row(y);
+            auto source_row = views.source.get_row(y);
+            for (u64 x = 0; x < views.destination.width; x++)
+            {
+                operation(destination_row + x, source_row[x]);
+            }
+        }
+        return;
+    }
+    for (auto y = views.destination.height; y-- > 0;)
+    {
+        auto destination_row = views.destination.get_row(y);
+        auto source_row = views.source.get_row(y);
+        for (auto x = views.destination.width; x-- > 0;)
+        {
+            operation(destination_row + x, source_row[x]);
+        }
+    }
+}
+
+void blit(ImageView destination, Vector2<u64> destination_position, ImageView source, Rectangle source_rectangle, Rectangle clip)
+{
+    auto zone = profile_begin("blit");
+    auto views = clip_blit(destination, destination_position, source, source_rectangle, clip);
+    if (!views.is_backward())
+    {
+        for (u64 y = 0; y < views.destination.height; y++)
+        {
+            copy_pixels_forward(views.destination.get_row(y), views.source.get_row(y), views.destination.width);
+        }
+    }
+    else
+    {
+        for (auto y = views.destination.height; y-- > 0;)
+        {
+            copy_pixels_backward(views.destination.get_row(y), views.source.get_row(y), views.destination.width);
+        }
+    }
+    profile_end(zone);
+}
+
+void blit(ImageView destination, Vector2<u64> destination_position, ImageView source, Rectangle source_rectangle)
+{
+    blit(destination, destination_position, source, source_rectangle, get_whole_view_rectangle(destination));
+}
+
+void blit(ImageView destination, Vector2<u64> destination_position, ImageView source)
+{
+    blit(destination, destination_position, source, get_whole_view_rectangle(source), get_whole_view_rectangle(destination));
+}
+
+// source pixels equal to `key` are left out, for sprites and glyph lines rendered over a known background
+void blit_color_keyed(ImageView destination, Vector2<u64> destination_position, ImageView source, Rectangle source_rectangle, Pixel key, Rectangle clip)
+{
+    auto zone = profile_begin("blit_color_keyed");
+    auto views = clip_blit(destination, destination_position, source, source_rectangle, clip);
+    for_each_blit_pixel(views, [&](Pixel* destination_pixel, Pixel source_pixel)
+    {
+        if (source_pixel != key)
+        {
+            *destination_pixel = source_pixel;
+        }
+    });
+    profile_end(zone);
+}
+
+void blit_color_keyed(ImageView destination, Vector2<u64> destination_position, ImageView source, Rectangle source_rectangle, Pixel key)
+{
+    blit_color_keyed(destination, destination_position, source, source_rectangle, key, get_whole_view_rectangle(destination));
+}
+
+// `source` over `destination` with the source's top byte as alpha, not premultiplied; X11 ignores that byte,
+// so it's only meaningful in images rendered for blending; the result's alpha is the usual a + (1 - a) * b
+Pixel blend_pixel(Pixel destination, Pixel source)
+{
+    u32 alpha = source >> 24;
+    if (alpha == 0xFF)
+    {
+        return source;
+    }
+    if (alpha == 0)
+    {
+        return destination;
+    }
+    // red and blue, then alpha and green, each pair as two 16-bit lanes; 255 * 255 fits a lane, so nothing carries
+    auto inverse_alpha = 0xFF - alpha;
+    u32 red_blue = (source & 0x00FF00FF) * alpha + (destination & 0x00FF00FF) * inverse_alpha;
+    u32 alpha_green = (((source >> 8) & 0x00FF00FF) | 0x00FF0000) * alpha + ((destination >> 8) & 0x00FF00FF) * inverse_alpha;
+    // x / 255 as (x + 1 + x / 256) / 256 in every lane
+    red_blue = ((red_blue + 0x00010001 + ((red_blue >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    alpha_green = ((alpha_green + 0x00010001 + ((alpha_green >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    return red_blue | (alpha_green << 8);
+}
+
+void blit_blended(ImageView destination, Vector2<u64> destination_position, ImageView source, Rectangle source_rectangle, Rectangle clip)
+{
+    auto zone = profile_begin("blit_blended");
+    auto views = clip_blit(destination, destination_position, source, source_rectangle, clip);
+    for_each_blit_pixel(views, [&](Pixel* destination_pixel, Pixel source_pixel)
+    {
+        *destination_pixel = blend_pixel(*destination_pixel, source_pixel);
+    });
+    profile_end(zone);
+}
+
+void blit_blended(ImageView destination, Vector2<u64> destination_position, ImageView source, Rectangle source_rectangle)
+{
+    blit_blended(destination, destination_position, source, source_rectangle, get_whole_view_rectangle(destination));
+}
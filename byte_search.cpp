@@ -0,0 +1,34 @@
+// word-at-a-time byte scanning: eight bytes are compared per u64, and the carries of one subtraction mark the
+// bytes that match
+
+const u64 BYTE_SEARCH_LOW_BITS = 0x0101010101010101;
+const u64 BYTE_SEARCH_HIGH_BITS = 0x8080808080808080;
+
+// has the high bit set in every byte of the result where the byte of `word` equals `value`;
+// only the lowest set bit is exact, which is the only one that gets used
+u64 get_matching_bytes(u64 word, u64 repeated_value)
+{
+    auto difference = word ^ repeated_value;
+    return (difference - BYTE_SEARCH_LOW_BITS) & ~difference & BYTE_SEARCH_HIGH_BITS;
+}
+
+// index of the first occurrence of value, or size if there is none
+u64 find_byte(byte* data, u64 size, byte value)
+{
+    auto repeated_value = BYTE_SEARCH_LOW_BITS * value;
+    u64 i = 0;
+    while (i + 8 <= size)
+    {
+        auto matches = get_matching_bytes(*(u64*)(data + i), repeated_value);
+        if (matches != 0)
+        {
+            return i + __builtin_ctzll(matches) / 8;
+        }
+        i += 8;
+    }
+    while (i < size && data[i] != value)
+    {
+        i++;
+    }
+    return i;
+}
@@ -0,0 +1,212 @@
+// pasting from the CLIPBOARD selection: the owner converts it into a property on our window, which is read
+// in chunks straight into the input's gap buffer; big selections come either as one huge property read one
+// chunk per frame, or through the INCR protocol, where the owner hands the data over a property at a time
+
+const u32 CLIPBOARD_CHUNK_SIZE_IN_DWORDS = 256 * 1024; // 1 MB per GetProperty reply
+const u64 CLIPBOARD_MAX_RESERVED_SIZE = 1024 * 1024 * 1024; // how far the owner's word on a paste's size is taken
+
+enum ClipboardPasteState : u8
+{
+    ClipboardPasteStateIdle,
+    ClipboardPasteStateWaitingForSelection, // ConvertSelection was sent
+    ClipboardPasteStateWaitingForReply, // a GetProperty was sent
+    ClipboardPasteStateWaitingForChunk, // INCR, the owner hasn't put the next chunk into the property yet
+    ClipboardPasteStateReadyForNextChunk, // the rest of the property is requested in the next update
+};
+
+struct ClipboardPaste
+{
+    X11Atom clipboard_atom;
+    X11Atom utf8_string_atom;
+    X11Atom incr_atom;
+    X11Atom property_atom; // the property on our window that the selection gets converted into
+
+    ClipboardPasteState state;
+    u32 window_id; // the one Ctrl+V was pressed in
+    u64 input_index; // of that window's inputs, the one that had the focus then; the whole paste goes into it
+    X11Atom target; // UTF8_STRING, or STRING when the owner doesn't support UTF8_STRING
+    bool is_incremental;
+    u32 offset_in_dwords; // into the property
+    u16 request_sequence_number; // of the request whose reply or error is awaited
+
+    static ClipboardPaste construct(X11Connection* connection)
+    {
+        ClipboardPaste result;
+        result.window_id = 0;
+        result.input_index = 0;
+        result.clipboard_atom = connection->intern_atom("CLIPBOARD");
+        result.utf8_string_atom = connection->intern_atom("UTF8_STRING");
+        result.incr_atom = connection->intern_atom("INCR");
+        result.property_atom = connection->intern_atom("PASTE_BUFFER");
+        result.state = ClipboardPasteStateIdle;
+        return result;
+    }
+
+    void convert_selection(X11Connection* connection, u32 time)
+    {
+        X11ConvertSelectionRequest request;
+        request.type = X11RequestTypeConvertSelection;
+        request.request_size_in_dwords = sizeof(request) / 4;
+        request.requestor_window_id = window_id;
+        request.selection = clipboard_atom;
+        request.target = target;
+        request.property = property_atom;
+        request.time = time;
+        request_sequence_number = connection->send_request("convert selection", &request, sizeof(request));
+        state = ClipboardPasteStateWaitingForSelection;
+    }
+
+    // the property is deleted by the server once it's been read up to its end, which is what tells an INCR
+    // owner to put the next chunk into it
+    void request_chunk(X11Connection* connection)
+    {
+        X11GetPropertyRequest request;
+        request.type = X11RequestTypeGetProperty;
+        request.should_delete = true;
+        request.request_size_in_dwords = sizeof(request) / 4;
+        request.window_id = window_id;
+        request.property = property_atom;
+        request.property_type = X11_ATOM_ANY_PROPERTY_TYPE;
+        request.offset_in_dwords = offset_in_dwords;
+        request.size_in_dwords = CLIPBOARD_CHUNK_SIZE_IN_DWORDS;
+        request_sequence_number = connection->send_request("get property", &request, sizeof(request));
+        state = ClipboardPasteStateWaitingForReply;
+    }
+
+    void delete_property(X11Connection* connection)
+    {
+        X11DeletePropertyRequest request;
+        request.type = X11RequestTypeDeleteProperty;
+        request.request_size_in_dwords = sizeof(request) / 4;
+        request.window_id = window_id;
+        request.property = property_atom;
+        connection->send_request("delete property", &request, sizeof(request));
+    }
+
+    // Ctrl+V, `time` is the key press's; ignored while another paste is still going on
+    void start(X11Connection* connection, u32 paste_window_id, u64 paste_input_index, u32 time)
+    {
+        if (state != ClipboardPasteStateIdle)
+        {
+            return;
+        }
+        window_id = paste_window_id;
+        input_index = paste_input_index;
+        target = utf8_string_atom;
+        convert_selection(connection, time);
+    }
+
+    void handle_events(X11Connection* connection, List<X11Event> events)
+    {
+        for (u64 i = 0; i < events.size; i++)
+        {
+            auto event = &events.data[i];
+            if (event->type == X11EventTypeSelectionNotify && state == ClipboardPasteStateWaitingForSelection)
+            {
+                auto selection_notify = (X11EventSelectionNotify*)event;
+                if (selection_notify->property != X11_ATOM_NONE)
+                {
+                    is_incremental = false;
+                    offset_in_dwords = 0;
+                    request_chunk(connection);
+                }
+                else if (target == utf8_string_atom)
+                { // old owners only know STRING
+                    target = X11_ATOM_STRING;
+                    convert_selection(connection, selection_notify->time);
+                }
+                else
+                {
+                    state = ClipboardPasteStateIdle;
+                }
+            }
+            else if (event->type == X11EventTypePropertyNotify && state == ClipboardPasteStateWaitingForChunk)
+            {
+                auto property_notify = (X11EventPropertyNotify*)event;
+                if (property_notify->window_id == window_id && property_notify->property == property_atom && property_notify->state == X11PropertyStateNewValue)
+                {
+                    offset_in_dwords = 0;
+                    request_chunk(connection);
+                }
+            }
+            else if (event->type == X11EventTypeError && state != ClipboardPasteStateIdle)
+            {
+                if (*(u16*)(event->data + 1) == request_sequence_number)
+                {
+                    state = ClipboardPasteStateIdle;
+                }
+            }
+        }
+    }
+
+    // large non-incremental properties are read a chunk per frame, so a huge paste doesn't stall rendering
+    void update(X11Connection* connection)
+    {
+        if (state == ClipboardPasteStateReadyForNextChunk)
+        {
+            request_chunk(connection);
+        }
+    }
+
+    // `reply` is the first 32 bytes of a reply, returns false if the reply isn't ours,
+    // otherwise its value is read from the socket right into the input's text
+    bool handle_reply(X11Connection* connection, X11Event* reply, InputState* input)
+    {
+        auto header = (X11GetPropertyReplyHeader*)reply;
+        if (state != ClipboardPasteStateWaitingForReply || header->sequence_number != request_sequence_number)
+        {
+            return false;
+        }
+
+        u64 body_size = header->reply_size_in_dwords * 4;
+        if (header->property_type == incr_atom)
+        { // the value is a lower bound of the total size; deleting the property starts the transfer
+            u32 size_lower_bound = 0;
+            if (header->format == 32 && header->value_count != 0)
+            {
+                connection->read_exactly(&size_lower_bound, sizeof(size_lower_bound));
+                body_size -= sizeof(size_lower_bound);
+            }
+            connection->skip_bytes(body_size);
+            // the gap is made big enough once, instead of doubling the buffer, and copying the text so far, again and again
+            input->text.reserve_gap(min((u64)size_lower_bound, CLIPBOARD_MAX_RESERVED_SIZE));
+            is_incremental = true;
+            delete_property(connection);
+            state = ClipboardPasteStateWaitingForChunk;
+            return true;
+        }
+        if (header->format != 8)
+        { // not text, or the property is gone
+            connection->skip_bytes(body_size);
+            input->on_text_inserted(0, true);
+            state = ClipboardPasteStateIdle;
+            return true;
+        }
+
+        u64 value_size = header->value_count;
+        if (!is_incremental && offset_in_dwords == 0)
+        { // the whole size is known from the first chunk on
+            input->text.reserve_gap(min(value_size + header->bytes_after, CLIPBOARD_MAX_RESERVED_SIZE));
+        }
+        connection->read_exactly(input->text.reserve_gap(value_size), value_size);
+        input->text.commit_gap(value_size);
+        connection->skip_bytes(body_size - value_size); // padding
+
+        auto is_last_chunk = is_incremental ? value_size == 0 : header->bytes_after == 0;
+        input->on_text_inserted(value_size, is_last_chunk);
+        if (is_last_chunk)
+        {
+            state = ClipboardPasteStateIdle;
+        }
+        else if (header->bytes_after != 0)
+        {
+            offset_in_dwords += value_size / 4;
+            state = ClipboardPasteStateReadyForNextChunk;
+        }
+        else
+        {
+            state = ClipboardPasteStateWaitingForChunk;
+        }
+        return true;
+    }
+};
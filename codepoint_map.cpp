@@ -0,0 +1,95 @@
+// two-level table over the whole unicode range: a directory of page pointers,
+// and pages of CODEPOINT_PAGE_SIZE values that only get allocated once something is stored in them
+
+const u64 CODEPOINT_PAGE_SIZE = 128;
+const u64 CODEPOINT_PAGE_COUNT = (UNICODE_MAX_CODEPOINT + 1) / CODEPOINT_PAGE_SIZE;
+
+template <typename T>
+struct CodepointPage
+{
+    T values[CODEPOINT_PAGE_SIZE];
+    u64 is_mapped[CODEPOINT_PAGE_SIZE / 64]; // one bit per value
+
+    constexpr bool contains(u64 index) const
+    {
+        return is_mapped[index / 64] & (1ull << (index % 64));
+    }
+};
+
+template <typename T>
+struct CodepointMap
+{
+    CodepointPage<T>** pages; // CODEPOINT_PAGE_COUNT entries, null while a page is empty
+    bool owns_directory;
+
+    // the directory is anonymous memory, so only the parts of it that get written are backed by pages
+    static CodepointMap allocate()
+    {
+        CodepointMap result;
+        result.pages = (CodepointPage<T>**)map_memory(
+            CODEPOINT_PAGE_COUNT * sizeof(CodepointPage<T>*),
+            LINUX_PROTECTION_READ | LINUX_PROTECTION_WRITE,
+            LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS
+        );
+        assert(result.pages != nullptr, "CodepointMap::allocate: failed to allocate page directory");
+        result.owns_directory = true;
+        return result;
+    }
+
+    // for maps with static storage: the directory is expected to be zero initialized
+    static constexpr CodepointMap construct(CodepointPage<T>** pages)
+    {
+        CodepointMap result = {};
+        result.pages = pages;
+        result.owns_directory = false;
+        return result;
+    }
+
+    T* get(u32 codepoint)
+    {
+        if (codepoint > UNICODE_MAX_CODEPOINT)
+        {
+            return nullptr;
+        }
+        auto page = pages[codepoint / CODEPOINT_PAGE_SIZE];
+        auto index = codepoint % CODEPOINT_PAGE_SIZE;
+        if (page == nullptr || !page->contains(index))
+        {
+            return nullptr;
+        }
+        return &page->values[index];
+    }
+
+    void set(u32 codepoint, T value)
+    {
+        assert(codepoint <= UNICODE_MAX_CODEPOINT, "CodepointMap::set: codepoint out of range: ", (u64)codepoint);
+        auto page = &pages[codepoint / CODEPOINT_PAGE_SIZE];
+        if (*page == nullptr)
+        {
+            *page = (CodepointPage<T>*)default_allocate(sizeof(CodepointPage<T>));
+            for (u64 i = 0; i < CODEPOINT_PAGE_SIZE / 64; i++)
+            {
+                (*page)->is_mapped[i] = 0;
+            }
+        }
+        auto index = codepoint % CODEPOINT_PAGE_SIZE;
+        (*page)->values[index] = value;
+        (*page)->is_mapped[index / 64] |= 1ull << (index % 64);
+    }
+
+    void deallocate()
+    {
+        for (u64 page_i = 0; page_i < CODEPOINT_PAGE_COUNT; page_i++)
+        {
+            if (pages[page_i] != nullptr)
+            {
+                default_deallocate(pages[page_i]);
+                pages[page_i] = nullptr;
+            }
+        }
+        if (owns_directory)
+        {
+            unmap_memory(pages, CODEPOINT_PAGE_COUNT * sizeof(CodepointPage<T>*));
+        }
+    }
+};
@@ -0,0 +1,307 @@
+// read-only view of a (possibly huge) text file: the file is mapped, lines are indexed a chunk per frame,
+// and only the lines inside the viewport are ever touched when rendering, and of them only what fits its width
+
+const u64 DOCUMENT_LINES_PER_CHECKPOINT = 64;
+const u64 DOCUMENT_INDEX_CHUNK_SIZE = 256 * 1024; // bytes scanned per index_next_chunk call, between two clock checks
+const u64 DOCUMENT_UPDATE_TIME_BUDGET = 1000 * 1000; // in nanoseconds, for indexing and searching together
+const u64 DOCUMENT_SCROLL_WHEEL_LINES = 3;
+
+const Pixel SEARCH_HIGHLIGHT_COLOR = 0x00FFE060;
+
+// `text` is the line, starting at `line_offset` of the searched text
+void render_search_highlights(
+    TextSearch* search,
+    String text,
+    u64 line_offset,
+    TextLine line,
+    ImageView image,
+    Vector2<u64> line_position,
+    GlyphScale* scale,
+    Pixel color
+)
+{
+    auto line_end = line_offset + line.start + line.size;
+    for (
+        auto match_i = search->find_first_match(line_offset + line.start);
+        match_i < search->matches.size && search->matches.data[match_i] < line_end;
+        match_i++)
+    {
+        auto match_start = search->matches.data[match_i] - line_offset;
+        auto match_end = min(match_start + search->needle_size, (u64)line.start + line.size);
+        String before_match;
+        before_match.data = text.data + line.start;
+        before_match.size = match_start - line.start;
+        String match;
+        match.data = text.data + match_start;
+        match.size = match_end - match_start;
+        auto match_x = measure_text(before_match, scale->size).x;
+        auto match_width = min(measure_text(match, scale->size).x, line.width - match_x);
+        render_filled_box(
+            image,
+            Vector2<u64>::construct(line_position.x + match_x, line_position.y),
+            Vector2<u64>::construct(match_width, scale->height),
+            color
+        );
+    }
+}
+
+struct DocumentView
+{
+    MappedFile file;
+    // byte offset of every DOCUMENT_LINES_PER_CHECKPOINT-th line, a line is found by scanning forward from its checkpoint
+    List<u64> line_checkpoints;
+    u64 indexed_size; // in bytes
+    u64 indexed_line_count; // lines whose start is known
+    u64 first_visible_line;
+    u64 font_size;
+    Pixel text_color;
+    // where the lines from first_visible_line on start, one more than fit into the viewport, so that every one of
+    // them ends right before the next one's start; only looked for again after a scroll, a resize, or once indexing
+    // found lines that were missing, so a frame doesn't scan even the visible lines to their ends
+    List<u64> visible_line_starts;
+    List<u64> previous_line_starts; // visible_line_starts before the last update, lines still in view reuse them
+    u64 visible_lines_first_line; // what visible_line_starts was looked for with
+    u64 visible_lines_row_count;
+    TextSearch search; // over the whole file, only valid while has_search
+    bool has_search;
+    u64 needle_generation; // of the GapBuffer the search's needle was taken from
+
+    static Option<DocumentView> open(CStringView path, u64 font_size, Pixel text_color = BLACK)
+    {
+        auto maybe_file = MappedFile::open(path);
+        if (!maybe_file.has_data)
+        {
+            return Option<DocumentView>::empty();
+        }
+
+        DocumentView result;
+        result.file = maybe_file.value;
+        result.line_checkpoints = List<u64>::allocate();
+        result.line_checkpoints.push(0);
+        result.indexed_size = 0;
+        result.indexed_line_count = 1;
+        result.first_visible_line = 0;
+        result.font_size = font_size;
+        result.text_color = text_color;
+        result.visible_line_starts = List<u64>::allocate();
+        result.previous_line_starts = List<u64>::allocate();
+        result.visible_lines_first_line = 0;
+        result.visible_lines_row_count = 0;
+        result.has_search = false;
+        result.needle_generation = 0;
+        return Option<DocumentView>::construct(result);
+    }
+
+    void dispose()
+    {
+        if (has_search)
+        {
+            search.deallocate();
+        }
+        previous_line_starts.deallocate();
+        visible_line_starts.deallocate();
+        line_checkpoints.deallocate();
+        file.dispose();
+    }
+
+    bool is_indexing_done()
+    {
+        return indexed_size == file.size;
+    }
+
+    // indexing and searching both grow lists from frame to frame
+    bool is_busy()
+    {
+        return !is_indexing_done() || (has_search && !search.is_done());
+    }
+
+    // every window's search input can be passed every frame: only an edit newer than the needle restarts the
+    // search, so the text is never compared, and an empty needle stops it
+    void search_for(GapBuffer* text)
+    {
+        if (text->generation <= needle_generation)
+        {
+            return;
+        }
+        needle_generation = text->generation;
+        if (has_search)
+        {
+            search.deallocate();
+            has_search = false;
+        }
+        if (text->get_size() == 0)
+        {
+            return;
+        }
+        search = TextSearch::start(file.data, file.size, nullptr, 0, text->get_before_caret(), text->get_after_caret());
+        has_search = true;
+    }
+
+    // meant to be called once per frame, however many windows show the document: indexing and searching share
+    // the budget, and while both have work left indexing only gets half, so matches show up during indexing too;
+    // returns whether there was any work, the frame may have allocated even if it's all done now
+    bool update(u64 time_budget = DOCUMENT_UPDATE_TIME_BUDGET)
+    {
+        if (!is_busy())
+        {
+            return false;
+        }
+        auto now = get_monotonic_time();
+        auto deadline = now + time_budget;
+        auto is_searching = has_search && !search.is_done();
+        auto indexing_deadline = is_searching ? now + time_budget / 2 : deadline;
+        while (!is_indexing_done() && now < indexing_deadline)
+        {
+            index_next_chunk();
+            now = get_monotonic_time();
+        }
+        if (is_searching && now < deadline)
+        {
+            search.run_slice(deadline - now);
+        }
+        return true;
+    }
+
+    // a chunk at a time, so the first frame doesn't wait for the whole file
+    void index_next_chunk(u64 budget = DOCUMENT_INDEX_CHUNK_SIZE)
+    {
+        auto chunk_end = min(indexed_size + budget, file.size);
+        while (indexed_size < chunk_end)
+        {
+            auto newline_i = indexed_size + find_byte(file.data + indexed_size, chunk_end - indexed_size, '\n');
+            if (newline_i == chunk_end)
+            {
+                indexed_size = chunk_end;
+                break;
+            }
+            indexed_size = newline_i + 1;
+            if (indexed_line_count % DOCUMENT_LINES_PER_CHECKPOINT == 0)
+            {
+                line_checkpoints.push(indexed_size);
+            }
+            indexed_line_count++;
+        }
+    }
+
+    u64 get_line_start(u64 line)
+    {
+        assert(line < indexed_line_count, "DocumentView::get_line_start: line isn't indexed yet: ", line);
+        auto result = line_checkpoints.data[line / DOCUMENT_LINES_PER_CHECKPOINT];
+        for (u64 i = 0; i < line % DOCUMENT_LINES_PER_CHECKPOINT; i++)
+        {
+            result += find_byte(file.data + result, file.size - result, '\n') + 1;
+        }
+        return result;
+    }
+
+    u64 get_line_height()
+    {
+        return get_glyph_scale(font_size)->height;
+    }
+
+    void scroll_by(s64 lines)
+    {
+        auto target = (s64)first_visible_line + lines;
+        first_visible_line = target < 0 ? 0 : min((u64)target, indexed_line_count - 1);
+    }
+
+    // Home and End need Control, without it they're left to whatever has the keyboard focus
+    void handle_events(List<X11Event> events, u64 viewport_height)
+    {
+        s64 page_size = max(viewport_height / get_line_height(), (u64)1);
+        for (u64 i = 0; i < events.size; i++)
+        {
+            if (events.data[i].type == X11EventTypeButtonPress)
+            {
+                auto button_press = (X11EventKeyPress*)&events.data[i]; // same layout, key_code is the button
+                if ((X11Button)button_press->key_code == X11ButtonScrollUp)
+                {
+                    scroll_by(-(s64)DOCUMENT_SCROLL_WHEEL_LINES);
+                }
+                else if ((X11Button)button_press->key_code == X11ButtonScrollDown)
+                {
+                    scroll_by(DOCUMENT_SCROLL_WHEEL_LINES);
+                }
+                continue;
+            }
+            if (events.data[i].type != X11EventTypeKeyPress)
+            {
+                continue;
+            }
+            auto event = *(X11EventKeyPress*)(&events.data[i]);
+            auto is_control_down = (event.state & X11ModifierKeyControl) != 0;
+            switch (event.key_code)
+            {
+                case X11KeyCodeUp: scroll_by(-1); break;
+                case X11KeyCodeDown: scroll_by(1); break;
+                case X11KeyCodePageUp: scroll_by(-page_size); break;
+                case X11KeyCodePageDown: scroll_by(page_size); break;
+                case X11KeyCodeHome: first_visible_line = is_control_down ? 0 : first_visible_line; break;
+                case X11KeyCodeEnd: scroll_by(is_control_down ? indexed_line_count : 0); break;
+                default: break;
+            }
+        }
+    }
+
+    // scrolling by a line only scans the line that comes into view, a line as long as the file included
+    void update_visible_lines(u64 row_count)
+    {
+        auto known_row_count = visible_line_starts.size != 0 ? visible_line_starts.size - 1 : 0;
+        auto is_missing_lines = known_row_count < row_count && first_visible_line + known_row_count < indexed_line_count;
+        if (visible_lines_first_line == first_visible_line && visible_lines_row_count == row_count && !is_missing_lines && visible_line_starts.size != 0)
+        {
+            return;
+        }
+        auto previous_first_line = visible_lines_first_line;
+        auto swapped = previous_line_starts;
+        previous_line_starts = visible_line_starts;
+        visible_line_starts = swapped;
+        visible_lines_first_line = first_visible_line;
+        visible_lines_row_count = row_count;
+        visible_line_starts.clear();
+        auto end_line = min(indexed_line_count, first_visible_line + row_count); // its start ends the last row
+        for (auto line = first_visible_line; line <= end_line; line++)
+        {
+            u64 line_start;
+            if (line >= previous_first_line && line - previous_first_line < previous_line_starts.size)
+            {
+                line_start = previous_line_starts.data[line - previous_first_line];
+            }
+            else if (line == first_visible_line)
+            {
+                line_start = get_line_start(line);
+            }
+            else
+            {
+                auto previous_start = visible_line_starts.data[visible_line_starts.size - 1];
+                line_start = previous_start + find_byte(file.data + previous_start, file.size - previous_start, '\n') + 1;
+            }
+            visible_line_starts.push(line_start);
+        }
+    }
+
+    // long lines are cut off at the right edge of the viewport;
+    // matches of a search over this document's file get highlighted, as many as have been found so far
+    void render(ImageView image, Vector2<u64> position, Vector2<u64> dimensions, TextSearch* search = nullptr, Pixel highlight_color = SEARCH_HIGHLIGHT_COLOR)
+    {
+        auto scale = get_glyph_scale(font_size);
+        update_visible_lines(dimensions.y / scale->height);
+        auto line_position = position;
+        for (u64 i = 0; i + 1 < visible_line_starts.size; i++, line_position.y += scale->height)
+        {
+            auto line_start = visible_line_starts.data[i];
+            String text; // just the line: layout stops at its end, and offsets stay small in multi-gigabyte files
+            text.data = (char*)file.data + line_start;
+            text.size = min(visible_line_starts.data[i + 1], file.size + 1) - 1 - line_start;
+            auto line_break = layout_next_line(text, 0, dimensions.x, scale); // stops at the right edge
+            if (search != nullptr)
+            {
+                render_search_highlights(search, text, line_start, line_break.line, image, line_position, scale, highlight_color);
+            }
+            if (line_break.line.width <= dimensions.x)
+            {
+                render_text_line(text, line_break.line, text_color, image, line_position, scale);
+            }
+        }
+    }
+};
@@ -0,0 +1,414 @@
+// loads PSF2 console fonts and BDF fonts by mapping the file into memory,
+// glyph bitmaps are never copied out of the mapping, only their offsets are indexed
+
+const u32 PSF2_MAGIC = 0x864AB572;
+const u32 PSF2_FLAG_HAS_UNICODE_TABLE = 0x01;
+const byte PSF2_UNICODE_SEPARATOR = 0xFF;
+const byte PSF2_UNICODE_SEQUENCE_START = 0xFE;
+
+struct Psf2Header
+{
+    u32 magic;
+    u32 version;
+    u32 header_size;
+    u32 flags;
+    u32 glyph_count;
+    u32 bytes_per_glyph;
+    u32 height;
+    u32 width;
+};
+
+const u64 BITMAP_FONT_MAX_GLYPH_WIDTH = 64; // a glyph row has to fit into a u64
+
+enum BitmapFontFormat : u8
+{
+    BitmapFontFormatPsf2,
+    BitmapFontFormatBdf,
+};
+
+u8 parse_hex_digit(byte digit)
+{
+    if (digit >= '0' && digit <= '9') { return digit - '0'; }
+    if (digit >= 'a' && digit <= 'f') { return digit - 'a' + 10; }
+    if (digit >= 'A' && digit <= 'F') { return digit - 'A' + 10; }
+    return 0;
+}
+
+struct BitmapGlyph
+{
+    byte* rows; // points into the mapped font file
+    u64 row_stride; // in bytes
+    u64 width;
+    u64 height;
+    s64 offset_x; // position of the bitmap inside the font's cell
+    s64 offset_y;
+    bool is_hex; // BDF keeps rows as lines of hex digits
+
+    // pixels are left-aligned: bit 63 is the leftmost pixel of the row
+    u64 get_row(u64 row)
+    {
+        auto row_data = rows + row * row_stride;
+        auto bytes_per_row = (width + 7) / 8;
+        u64 result = 0;
+        for (u64 i = 0; i < bytes_per_row; i++)
+        {
+            u64 row_byte = is_hex
+                ? (parse_hex_digit(row_data[i * 2]) << 4) | parse_hex_digit(row_data[i * 2 + 1])
+                : row_data[i];
+            result |= row_byte << (56 - i * 8);
+        }
+        return result;
+    }
+};
+
+// BDF parsing helpers, all of them work on [cursor, end) of the mapped file
+
+bool bdf_line_starts_with(byte* cursor, byte* end, CStringView keyword)
+{
+    auto keyword_size = get_c_string_length(keyword);
+    if ((u64)(end - cursor) < keyword_size)
+    {
+        return false;
+    }
+    for (u64 i = 0; i < keyword_size; i++)
+    {
+        if (cursor[i] != keyword[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+byte* bdf_next_line(byte* cursor, byte* end)
+{
+    while (cursor < end && *cursor != '\n')
+    {
+        cursor++;
+    }
+    return cursor < end ? cursor + 1 : end;
+}
+
+s64 bdf_parse_number(byte** cursor, byte* end)
+{
+    while (*cursor < end && **cursor == ' ')
+    {
+        (*cursor)++;
+    }
+    bool is_negative = *cursor < end && **cursor == '-';
+    if (is_negative)
+    {
+        (*cursor)++;
+    }
+    s64 result = 0;
+    while (*cursor < end && **cursor >= '0' && **cursor <= '9')
+    {
+        result = result * 10 + (**cursor - '0');
+        (*cursor)++;
+    }
+    return is_negative ? -result : result;
+}
+
+struct BitmapFont
+{
+    MappedFile file;
+    BitmapFontFormat format;
+    u64 glyph_width; // size of the cell every glyph is placed into
+    u64 glyph_height;
+    CodepointMap<u32> glyph_offsets; // codepoint -> offset of the glyph inside the file
+
+    // PSF2
+    u64 bytes_per_glyph;
+
+    // BDF
+    s64 bounding_box_offset_x;
+    s64 bounding_box_offset_y;
+
+    static Option<BitmapFont> load(CStringView path)
+    {
+        auto maybe_file = MappedFile::open(path);
+        if (!maybe_file.has_data)
+        {
+            return Option<BitmapFont>::empty();
+        }
+
+        BitmapFont result;
+        result.file = maybe_file.value;
+        result.glyph_offsets = CodepointMap<u32>::allocate();
+
+        auto is_valid = result.file.size >= sizeof(Psf2Header) && ((Psf2Header*)result.file.data)->magic == PSF2_MAGIC
+            ? result.index_psf2()
+            : result.index_bdf();
+        if (!is_valid)
+        {
+            result.dispose();
+            return Option<BitmapFont>::empty();
+        }
+        return Option<BitmapFont>::construct(result);
+    }
+
+    bool index_psf2()
+    {
+        format = BitmapFontFormatPsf2;
+        auto header = (Psf2Header*)file.data;
+        glyph_width = header->width;
+        glyph_height = header->height;
+        bytes_per_glyph = header->bytes_per_glyph;
+        auto glyphs_end = (u64)header->header_size + (u64)header->glyph_count * bytes_per_glyph;
+        if (glyph_width == 0 || glyph_width > BITMAP_FONT_MAX_GLYPH_WIDTH
+            || bytes_per_glyph < (glyph_width + 7) / 8 * glyph_height
+            || glyphs_end > file.size)
+        {
+            return false;
+        }
+
+        if (!(header->flags & PSF2_FLAG_HAS_UNICODE_TABLE))
+        { // glyphs are indexed by codepoint directly
+            for (u64 glyph_i = 0; glyph_i < header->glyph_count && glyph_i <= UNICODE_MAX_CODEPOINT; glyph_i++)
+            {
+                glyph_offsets.set(glyph_i, header->header_size + glyph_i * bytes_per_glyph);
+            }
+            return true;
+        }
+
+        // unicode table: for every glyph a list of UTF-8 codepoints terminated by 0xFF,
+        // multi-codepoint sequences start with 0xFE and are skipped since we can't compose
+        auto cursor = file.data + glyphs_end;
+        auto end = file.data + file.size;
+        for (u64 glyph_i = 0; glyph_i < header->glyph_count && cursor < end; glyph_i++)
+        {
+            auto glyph_offset = header->header_size + glyph_i * bytes_per_glyph;
+            bool is_in_sequence = false;
+            while (cursor < end && *cursor != PSF2_UNICODE_SEPARATOR)
+            {
+                if (*cursor == PSF2_UNICODE_SEQUENCE_START)
+                {
+                    is_in_sequence = true;
+                    cursor++;
+                    continue;
+                }
+                auto decoded = decode_utf8_codepoint(cursor, end - cursor);
+                cursor += decoded.size;
+                if (!is_in_sequence && glyph_offsets.get(decoded.codepoint) == nullptr)
+                {
+                    glyph_offsets.set(decoded.codepoint, glyph_offset);
+                }
+            }
+            cursor++; // skip the separator
+        }
+        return true;
+    }
+
+    // only the ENCODING lines are looked at here, everything else about a glyph is read when it's drawn
+    bool index_bdf()
+    {
+        format = BitmapFontFormatBdf;
+        auto cursor = file.data;
+        auto end = file.data + file.size;
+        if (!bdf_line_starts_with(cursor, end, "STARTFONT"))
+        {
+            return false;
+        }
+
+        bool has_bounding_box = false;
+        while (cursor < end)
+        {
+            if (bdf_line_starts_with(cursor, end, "FONTBOUNDINGBOX "))
+            {
+                auto number_cursor = cursor + get_c_string_length("FONTBOUNDINGBOX ");
+                glyph_width = bdf_parse_number(&number_cursor, end);
+                glyph_height = bdf_parse_number(&number_cursor, end);
+                bounding_box_offset_x = bdf_parse_number(&number_cursor, end);
+                bounding_box_offset_y = bdf_parse_number(&number_cursor, end);
+                has_bounding_box = true;
+            }
+            else if (bdf_line_starts_with(cursor, end, "ENCODING "))
+            {
+                auto number_cursor = cursor + get_c_string_length("ENCODING ");
+                auto codepoint = bdf_parse_number(&number_cursor, end);
+                if (codepoint >= 0 && codepoint <= UNICODE_MAX_CODEPOINT)
+                {
+                    glyph_offsets.set(codepoint, cursor - file.data);
+                }
+            }
+            cursor = bdf_next_line(cursor, end);
+        }
+
+        return has_bounding_box && glyph_width != 0 && glyph_width <= BITMAP_FONT_MAX_GLYPH_WIDTH;
+    }
+
+    Option<BitmapGlyph> get_glyph(u32 codepoint)
+    {
+        auto glyph_offset = glyph_offsets.get(codepoint);
+        if (glyph_offset == nullptr)
+        {
+            return Option<BitmapGlyph>::empty();
+        }
+        auto glyph_data = file.data + *glyph_offset;
+
+        BitmapGlyph result;
+        if (format == BitmapFontFormatPsf2)
+        {
+            result.rows = glyph_data;
+            result.width = glyph_width;
+            result.height = glyph_height;
+            result.row_stride = (glyph_width + 7) / 8;
+            result.offset_x = 0;
+            result.offset_y = 0;
+            result.is_hex = false;
+            return Option<BitmapGlyph>::construct(result);
+        }
+
+        // BDF: walk from the ENCODING line to BBX and BITMAP
+        auto cursor = glyph_data;
+        auto end = file.data + file.size;
+        result.width = glyph_width;
+        result.height = glyph_height;
+        result.offset_x = 0;
+        result.offset_y = 0;
+        result.is_hex = true;
+        while (cursor < end && !bdf_line_starts_with(cursor, end, "ENDCHAR"))
+        {
+            if (bdf_line_starts_with(cursor, end, "BBX "))
+            {
+                auto number_cursor = cursor + get_c_string_length("BBX ");
+                result.width = bdf_parse_number(&number_cursor, end);
+                result.height = bdf_parse_number(&number_cursor, end);
+                auto bbx_offset_x = bdf_parse_number(&number_cursor, end);
+                auto bbx_offset_y = bdf_parse_number(&number_cursor, end);
+                result.offset_x = bbx_offset_x - bounding_box_offset_x;
+                result.offset_y = ((s64)glyph_height + bounding_box_offset_y) - ((s64)result.height + bbx_offset_y);
+                // rows get shifted by offset_x as u64s, so all of the glyph has to land within one
+                if (result.offset_x <= -(s64)BITMAP_FONT_MAX_GLYPH_WIDTH || result.offset_x >= (s64)BITMAP_FONT_MAX_GLYPH_WIDTH
+                    || result.offset_x + (s64)result.width > (s64)BITMAP_FONT_MAX_GLYPH_WIDTH)
+                {
+                    return Option<BitmapGlyph>::empty();
+                }
+            }
+            else if (bdf_line_starts_with(cursor, end, "BITMAP"))
+            {
+                result.rows = bdf_next_line(cursor, end);
+                result.row_stride = bdf_next_line(result.rows, end) - result.rows; // one row per line, CRLF included
+                if (result.width > BITMAP_FONT_MAX_GLYPH_WIDTH
+                    || result.rows + result.row_stride * result.height > end
+                    || result.row_stride < (result.width + 7) / 8 * 2)
+                {
+                    return Option<BitmapGlyph>::empty();
+                }
+                return Option<BitmapGlyph>::construct(result);
+            }
+            cursor = bdf_next_line(cursor, end);
+        }
+        return Option<BitmapGlyph>::empty();
+    }
+
+    void dispose()
+    {
+        glyph_offsets.deallocate();
+        file.dispose();
+    }
+};
+
+// makes the font's glyphs in [first_codepoint, last_codepoint] available to render_text,
+// glyphs are placed into the built-in GLYPH_WIDTH x GLYPH_HEIGHT cell and clipped to it;
+// ASCII always comes from the built-in font
+void add_glyphs_from_font(BitmapFont* font, u32 first_codepoint, u32 last_codepoint)
+{
+    for (u64 codepoint = max(first_codepoint, (u32)CODEPOINT_PAGE_SIZE); codepoint <= last_codepoint; codepoint++)
+    {
+        auto maybe_glyph = font->get_glyph(codepoint);
+        if (!maybe_glyph.has_data)
+        {
+            continue;
+        }
+        auto glyph = maybe_glyph.value;
+
+        GlyphRows glyph_rows;
+        for (u64 cell_y = 0; cell_y < GLYPH_HEIGHT; cell_y++)
+        {
+            glyph_rows.rows[cell_y] = 0;
+            auto glyph_y = (s64)cell_y - glyph.offset_y;
+            if (glyph_y < 0 || (u64)glyph_y >= glyph.height)
+            {
+                continue;
+            }
+            auto row = glyph.get_row(glyph_y);
+            row = glyph.offset_x >= 0 ? row >> glyph.offset_x : row << -glyph.offset_x;
+            glyph_rows.rows[cell_y] = row >> (64 - GLYPH_WIDTH);
+        }
+        extended_glyph_map.set(codepoint, glyph_rows);
+    }
+}
+
+void render_bitmap_font_text(
+    BitmapFont* font,
+    String text,
+    Pixel text_color,
+    ImageView image,
+    Vector2<u64> position,
+    u64 scale
+)
+{
+    auto advance = font->glyph_width * scale;
+    auto line_height = font->glyph_height * scale;
+    u64 x = position.x;
+    u64 y = position.y;
+    u64 text_i = 0;
+    while (text_i < text.size && y + line_height <= image.height)
+    {
+        auto decoded = decode_utf8_codepoint((byte*)text.data + text_i, text.size - text_i);
+        text_i += decoded.size;
+        if (decoded.codepoint == '\n')
+        {
+            x = position.x;
+            y += line_height;
+            continue;
+        }
+
+        if (x + advance > image.width)
+        {
+            x = position.x;
+            y += line_height;
+            if (y + line_height > image.height)
+            {
+                break;
+            }
+        }
+
+        auto maybe_glyph = font->get_glyph(decoded.codepoint);
+        if (!maybe_glyph.has_data)
+        {
+            maybe_glyph = font->get_glyph('?');
+        }
+        if (maybe_glyph.has_data)
+        {
+            auto glyph = maybe_glyph.value;
+            for (u64 glyph_y = 0; glyph_y < glyph.height; glyph_y++)
+            {
+                auto cell_y = (s64)glyph_y + glyph.offset_y;
+                if (cell_y < 0 || (u64)cell_y >= font->glyph_height)
+                {
+                    continue;
+                }
+                auto row = glyph.get_row(glyph_y);
+                for (u64 glyph_x = 0; glyph_x < glyph.width; glyph_x++)
+                {
+                    auto cell_x = (s64)glyph_x + glyph.offset_x;
+                    if (!(row & (1ull << (63 - glyph_x))) || cell_x < 0 || (u64)cell_x >= font->glyph_width)
+                    {
+                        continue;
+                    }
+                    for (u64 y_scale_i = 0; y_scale_i < scale; y_scale_i++)
+                    {
+                        for (u64 x_scale_i = 0; x_scale_i < scale; x_scale_i++)
+                        {
+                            image.get_row(y + cell_y * scale + y_scale_i)[x + cell_x * scale + x_scale_i] = text_color;
+                        }
+                    }
+                }
+            }
+        }
+
+        x += advance;
+    }
+}
@@ -0,0 +1,195 @@
+// text with a movable gap at the caret: inserting and deleting at the caret is O(1) amortized,
+// moving the caret costs as much as the distance moved
+
+u64 gap_buffer_edit_count; // of all buffers, so the newer of two edits has the higher generation
+
+struct GapBuffer
+{
+    char* data;
+    u64 capacity;
+    u64 gap_start; // == caret position
+    u64 gap_end;
+    u64 generation; // changes with every edit of the text, not with caret movement
+
+    static GapBuffer allocate(u64 capacity = 64)
+    {
+        GapBuffer result;
+        result.data = (char*)heap_allocate(capacity);
+        result.capacity = capacity;
+        result.gap_start = 0;
+        result.gap_end = capacity;
+        result.generation = 0;
+        return result;
+    }
+
+    void deallocate()
+    {
+        default_deallocate(data);
+    }
+
+    u64 get_size()
+    {
+        return capacity - (gap_end - gap_start);
+    }
+
+    u64 get_caret()
+    {
+        return gap_start;
+    }
+
+    // views into the buffer, only valid until the next edit
+    String get_before_caret()
+    {
+        String result;
+        result.data = data;
+        result.size = gap_start;
+        return result;
+    }
+
+    String get_after_caret()
+    {
+        String result;
+        result.data = data + gap_end;
+        result.size = capacity - gap_end;
+        return result;
+    }
+
+    void move_caret(u64 position)
+    {
+        assert(position <= get_size(), "GapBuffer::move_caret: position out of range: ", position);
+        while (gap_start > position)
+        {
+            gap_start--;
+            gap_end--;
+            data[gap_end] = data[gap_start];
+        }
+        while (gap_start < position)
+        {
+            data[gap_start] = data[gap_end];
+            gap_start++;
+            gap_end++;
+        }
+    }
+
+    // the caret always stays on a UTF-8 sequence boundary
+
+    u64 get_previous_boundary()
+    {
+        auto position = gap_start;
+        while (position != 0)
+        {
+            position--;
+            if ((data[position] & 0xC0) != 0x80)
+            {
+                break;
+            }
+        }
+        return position;
+    }
+
+    u64 get_next_boundary_after_gap()
+    {
+        auto position = gap_end;
+        if (position != capacity)
+        {
+            position++;
+        }
+        while (position != capacity && (data[position] & 0xC0) == 0x80)
+        {
+            position++;
+        }
+        return position;
+    }
+
+    void move_caret_left()
+    {
+        move_caret(get_previous_boundary());
+    }
+
+    void move_caret_right()
+    {
+        move_caret(gap_start + (get_next_boundary_after_gap() - gap_end));
+    }
+
+    void insert(char character)
+    {
+        if (gap_start == gap_end)
+        {
+            grow();
+        }
+        data[gap_start] = character;
+        gap_start++;
+        mark_edited();
+    }
+
+    void insert(String text)
+    {
+        for (u64 i = 0; i < text.size; i++)
+        {
+            insert(text.data[i]);
+        }
+    }
+
+    // both return the number of bytes deleted
+    u64 delete_backward()
+    {
+        auto new_gap_start = get_previous_boundary();
+        auto result = gap_start - new_gap_start;
+        gap_start = new_gap_start;
+        mark_edited();
+        return result;
+    }
+
+    u64 delete_forward()
+    {
+        auto new_gap_end = get_next_boundary_after_gap();
+        auto result = new_gap_end - gap_end;
+        gap_end = new_gap_end;
+        mark_edited();
+        return result;
+    }
+
+    // for writing straight into the buffer, e.g. from a socket: returns where at least `size` bytes
+    // can be written at the caret, commit_gap then makes `size` of them part of the text
+    char* reserve_gap(u64 size)
+    {
+        while (gap_end - gap_start < size)
+        {
+            grow();
+        }
+        return data + gap_start;
+    }
+
+    void commit_gap(u64 size)
+    {
+        assert(size <= gap_end - gap_start, "GapBuffer::commit_gap: more than the gap: ", size);
+        gap_start += size;
+        mark_edited();
+    }
+
+    void clear()
+    {
+        gap_start = 0;
+        gap_end = capacity;
+        mark_edited();
+    }
+
+    void mark_edited()
+    {
+        gap_buffer_edit_count++;
+        generation = gap_buffer_edit_count;
+    }
+
+    void grow()
+    {
+        auto new_capacity = capacity * 2;
+        auto new_data = (char*)heap_allocate(new_capacity);
+        auto after_gap_size = capacity - gap_end;
+        copy_memory(data, gap_start, new_data);
+        copy_memory(data + gap_end, after_gap_size, new_data + new_capacity - after_gap_size);
+        default_deallocate(data);
+        data = new_data;
+        gap_end = new_capacity - after_gap_size;
+        capacity = new_capacity;
+    }
+};
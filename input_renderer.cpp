@@ -6,141 +6,261 @@ struct InputState
     bool is_in_focus;
     Vector2<u64> position;
     Vector2<u64> dimensions;
-    String text;
+    GapBuffer text;
     Pixel text_color;
     u64 font_size;
     u64 timer;
 
+    // widths are kept up to date edit by edit, so an edit costs as much as the text it touches;
+    // the scroll is clamped at most once per frame, after all of the frame's key events were applied
+    bool is_layout_dirty;
+    u64 caret_x; // in pixels, relative to the start of the text
+    u64 text_width;
+    u64 scroll_x; // how much of the text is scrolled out on the left
+    u64 unmeasured_size; // inserted bytes right before the caret that end in an incomplete UTF-8 sequence
+
     static InputState construct(Vector2<u64> position, Vector2<u64> dimensions, u64 font_size, Pixel text_color = BLACK)
     {
         InputState result;
         result.is_in_focus = true;
         result.position = position;
         result.dimensions = dimensions;
-        result.text = String::allocate();
+        result.text = GapBuffer::allocate();
         result.text_color = text_color;
         result.font_size = font_size;
         result.timer = 0;
+        result.is_layout_dirty = true;
+        result.caret_x = 0;
+        result.text_width = 0;
+        result.scroll_x = 0;
+        result.unmeasured_size = 0;
         return result;
     }
-};
 
-// void render_line(Image image, Vector2<u64> start, Vector2<u64> end, u64 width, Pixel color)
-// {
-//     for (u64 y = start.y; y != end.y; y++)
-//     {
-//         for (u64 x = start.x; y != end.x; x++)
-//         {
-//             for (u64 i = x - width / 2;
-//             auto pixel_i = y * image.width + x;
-//             image.data[pixel_i] = 
-//         }
-//     }
-// }
-
-void render_box(Image image, Vector2<u64> position, Vector2<u64> dimensions, u64 width, Pixel color)
-{
-    for (u64 y = position.y; y < position.y + dimensions.y; y++)
+    // too small an input isn't drawn at all
+    bool has_room_for_text()
+    {
+        return dimensions.x >= padding * 2 + cursor_width && dimensions.y >= padding + font_size;
+    }
+
+    u64 get_text_area_width()
+    {
+        return dimensions.x - padding * 2;
+    }
+
+    // the input is a single line without hard breaks, so widths of adjacent pieces simply add up
+    u64 measure(String text)
+    {
+        return measure_text(text, font_size).x;
+    }
+
+    u64 measure_before_caret(u64 size)
+    {
+        auto before_caret = text.get_before_caret();
+        before_caret.data += before_caret.size - size;
+        before_caret.size = size;
+        return measure(before_caret);
+    }
+
+    u64 measure_after_caret(u64 size)
+    {
+        auto after_caret = text.get_after_caret();
+        after_caret.size = size;
+        return measure(after_caret);
+    }
+
+    // `size` bytes were written right before the caret without going through the methods below, e.g. by a
+    // clipboard transfer; an unfinished UTF-8 sequence at their end waits for the rest unless `is_complete`
+    void on_text_inserted(u64 size, bool is_complete)
     {
-        for (u64 x = position.x; x < position.x + dimensions.x; x++)
+        unmeasured_size += size;
+        auto inserted = (byte*)text.data + text.get_caret() - unmeasured_size;
+        u64 incomplete_size = is_complete ? 0 : get_incomplete_utf8_suffix_size(inserted, unmeasured_size);
+        auto inserted_size = unmeasured_size - incomplete_size;
+        replace_invalid_utf8(inserted, inserted_size, '?');
+        for (u64 i = 0; i < inserted_size; i++)
         {
-            if (x == position.x || y == position.y || x == position.x + dimensions.x - 1 || y == position.y + dimensions.y - 1)
+            if (inserted[i] == '\n' || inserted[i] == '\r' || inserted[i] == '\t')
             {
-                auto pixel_i = y * image.width + x;
-                image.data[pixel_i] = color;
+                inserted[i] = ' ';
             }
         }
+        String measured;
+        measured.data = (char*)inserted;
+        measured.size = inserted_size;
+        auto inserted_width = measure(measured);
+        caret_x += inserted_width;
+        text_width += inserted_width;
+        unmeasured_size = incomplete_size;
+        is_layout_dirty = true;
     }
-}
 
-void render_input_text(InputState state, Image target_image)
-{
-    auto text_width = state.text.size * GLYPH_WIDTH * state.font_size / GLYPH_WIDTH / 2 + state.is_in_focus * InputState::cursor_width;
-    auto input_width = state.dimensions.x - InputState::padding * 2;
-    if (text_width <= input_width)
-    {
-        render_text(
-            state.text,
-            state.text_color,
-            target_image,
-            state.position + InputState::padding,
-            state.font_size
-        );
+    void insert(char character)
+    {
+        on_text_inserted(0, true);
+        text.insert(character);
+        auto width = measure_before_caret(1);
+        caret_x += width;
+        text_width += width;
+    }
+
+    void delete_backward()
+    {
+        on_text_inserted(0, true);
+        auto width = measure_before_caret(text.get_caret() - text.get_previous_boundary());
+        text.delete_backward();
+        caret_x -= width;
+        text_width -= width;
+    }
+
+    void delete_forward()
+    {
+        on_text_inserted(0, true);
+        text_width -= measure_after_caret(text.get_next_boundary_after_gap() - text.gap_end);
+        text.delete_forward();
+    }
+
+    void move_caret_left()
+    {
+        on_text_inserted(0, true);
+        caret_x -= measure_before_caret(text.get_caret() - text.get_previous_boundary());
+        text.move_caret_left();
+    }
+
+    void move_caret_right()
+    {
+        on_text_inserted(0, true);
+        caret_x += measure_after_caret(text.get_next_boundary_after_gap() - text.gap_end);
+        text.move_caret_right();
     }
-    else
+
+    void move_caret_to_start()
     {
-        auto text_height = GLYPH_HEIGHT * state.font_size / GLYPH_HEIGHT;
-        auto buffer_image = Image::allocate(text_width, text_height);
-        buffer_image.clear(WHITE);
+        on_text_inserted(0, true);
+        text.move_caret(0);
+        caret_x = 0;
+    }
 
-        render_text(state.text, state.text_color, buffer_image, Vector2<u64>::construct(0, 0), state.font_size);
+    void move_caret_to_end()
+    {
+        on_text_inserted(0, true);
+        text.move_caret(text.get_size());
+        caret_x = text_width;
+    }
 
-        for (
-            u64 x = text_width - 1, target_x = state.position.x + state.dimensions.x - InputState::padding - state.is_in_focus * InputState::cursor_width;
-            target_x >= state.position.x + InputState::padding;
-            x--, target_x--)
+    void update_layout()
+    {
+        if (!is_layout_dirty)
         {
-            for (u64 y = 0, target_y = state.position.y + InputState::padding; y < text_height; y++, target_y++)
-            {
-                auto buffer_pixel_i = y * text_width + x;
-                auto target_pixel_i = target_y * target_image.width + target_x;
-                target_image.data[target_pixel_i] = buffer_image.data[buffer_pixel_i];
-            }
+            return;
         }
+        is_layout_dirty = false;
 
-        buffer_image.deallocate();
+        // keep the caret visible and don't leave empty space on the right when text gets deleted
+        auto visible_width = get_text_area_width() - cursor_width;
+        if (caret_x < scroll_x)
+        {
+            scroll_x = caret_x;
+        }
+        else if (caret_x > scroll_x + visible_width)
+        {
+            scroll_x = caret_x - visible_width;
+        }
+        scroll_x = min(scroll_x, text_width > visible_width ? text_width - visible_width : 0);
     }
-}
+};
 
-void render_input_cursor(InputState state, Image image)
+// `image` is the input's own view; only the glyphs inside the scrolled-to part of the text are drawn, the caret is
+// always in view, so they're found by walking back from it to the left edge and forward from it to the right edge
+void render_input_text(InputState state, ImageView image)
 {
-    if (state.is_in_focus && state.timer % 60 < 30)
+    auto scale = get_glyph_scale(state.font_size);
+    auto text_view = image.get_sub_view(
+        Vector2<u64>::construct(InputState::padding, InputState::padding),
+        Vector2<u64>::construct(state.get_text_area_width(), scale->height)
+    );
+
+    // the bytes of an unfinished paste at the caret aren't measured yet, they get drawn once they're complete
+    auto before_caret = state.text.get_before_caret();
+    before_caret.size -= state.unmeasured_size;
+    auto caret_x = (s64)state.caret_x - (s64)state.scroll_x;
+    auto visible_start = before_caret.size;
+    auto x = caret_x;
+    while (visible_start != 0 && x > 0)
     {
-        auto text_width = state.text.size * GLYPH_WIDTH * state.font_size / GLYPH_WIDTH / 2;
-        auto cursor_position_x = state.position.x + InputState::padding
-            + min(text_width, state.dimensions.x - InputState::padding * 2 - InputState::cursor_width);
-        for (u64 y = state.position.y + InputState::padding; y < state.position.y + InputState::padding + state.font_size; y++)
+        auto end = visible_start;
+        visible_start--;
+        while (visible_start != 0 && (before_caret.data[visible_start] & 0xC0) == 0x80)
         {
-            for (u64 x = cursor_position_x; x < cursor_position_x + InputState::cursor_width; x++)
-            {
-                image.data[y * image.width + x] = BLACK;
-            }
+            visible_start--;
         }
+        auto decoded = decode_utf8_codepoint((byte*)before_caret.data + visible_start, end - visible_start);
+        x -= scale->get_advance(decoded.codepoint);
     }
+    before_caret.data += visible_start;
+    before_caret.size -= visible_start;
+    render_text_run(before_caret, state.text_color, text_view, x, 0, scale);
+    render_text_run(state.text.get_after_caret(), state.text_color, text_view, caret_x, 0, scale);
 }
 
-void render_input(InputState* state, List<X11Event> events, Image image)
+void render_input_cursor(InputState state, ImageView image)
+{
+    if (state.is_in_focus && state.timer % 60 < 30)
+    {
+        render_filled_box(
+            image,
+            Vector2<u64>::construct(InputState::padding + state.caret_x - state.scroll_x, InputState::padding),
+            Vector2<u64>::construct(InputState::cursor_width, state.font_size),
+            BLACK
+        );
+    }
+}
+
+// all of the frame's events are applied to the text before anything gets measured
+void apply_input_events(InputState* state, List<X11Event> events)
 {
     for (u64 i = 0; i < events.size; i++)
     {
-        if (events.data[i].type == X11EventTypeKeyPress)
+        if (events.data[i].type != X11EventTypeKeyPress)
         {
-            auto event = *(X11EventKeyPress*)(&events.data[i]);
-            if (event.key_code == X11KeyCodeBackspace)
-            {
-                if (state->text.size != 0)
-                {
-                    state->text.pop();
-                }
-            }
-            else
+            continue;
+        }
+
+        auto event = *(X11EventKeyPress*)(&events.data[i]);
+        switch (event.key_code)
+        {
+            case X11KeyCodeBackspace: state->delete_backward(); break;
+            case X11KeyCodeDelete: state->delete_forward(); break;
+            case X11KeyCodeLeft: state->move_caret_left(); break;
+            case X11KeyCodeRight: state->move_caret_right(); break;
+            case X11KeyCodeHome: state->move_caret_to_start(); break;
+            case X11KeyCodeEnd: state->move_caret_to_end(); break;
+            default:
             {
                 auto maybe_char = event.to_char();
                 if (maybe_char.has_data)
                 {
-                    state->text.push(maybe_char.value);
+                    state->insert(maybe_char.value);
                 }
+                break;
             }
-            state->timer = 0; // reset timer on key press so that the cursor isn't blinking while typing
         }
+        state->is_layout_dirty = true;
+        state->timer = 0; // reset timer on key press so that the cursor isn't blinking while typing
     }
+}
+
+void render_input(InputState* state, List<X11Event> events, ImageView image)
+{
+    auto zone = profile_begin("render_input");
+    apply_input_events(state, events);
+    state->update_layout();
 
-    render_box(image, state->position, state->dimensions, 0, BLACK);
-    Vector2<u64> text_position;
-    text_position.y = state->position.y + (state->dimensions.y - state->font_size) / 2;
-    text_position.x = state->position.y + InputState::padding;
-    render_input_text(*state, image);
-    render_input_cursor(*state, image);
+    auto input_view = image.get_sub_view(state->position, state->dimensions);
+    render_box(input_view, Vector2<u64>::construct(0, 0), state->dimensions, 1, BLACK);
+    render_input_text(*state, input_view);
+    render_input_cursor(*state, input_view);
 
     state->timer++;
+    profile_end(zone);
 }
@@ -0,0 +1,248 @@
+// a window's inputs: a click focuses the one under the pointer, Tab and Shift+Tab move the focus along, and key
+// presses only go to the focused input; clicks find their input through a uniform grid over the inputs'
+// rectangles, so a click only looks at the few inputs of one cell, however many inputs there are
+
+const u64 WIDGET_GRID_CELL_SIZE = 64; // pixels
+
+// which inputs overlap each cell, packed back to back; rebuilt whenever the layout changes
+struct WidgetGrid
+{
+    u64 column_count;
+    u64 row_count;
+    List<u32> cell_starts; // column_count * row_count + 1 offsets into input_indices
+    List<u32> input_indices; // in the order the inputs were added, so the topmost comes last
+
+    static WidgetGrid allocate()
+    {
+        WidgetGrid result;
+        result.column_count = 0;
+        result.row_count = 0;
+        result.cell_starts = List<u32>::allocate();
+        result.input_indices = List<u32>::allocate();
+        return result;
+    }
+
+    void deallocate()
+    {
+        input_indices.deallocate();
+        cell_starts.deallocate();
+    }
+
+    // two passes over the inputs, one counts per cell and one fills the cells in
+    void build(List<InputState> inputs)
+    {
+        u64 right = 0;
+        u64 bottom = 0;
+        for (u64 i = 0; i < inputs.size; i++)
+        {
+            right = max(right, inputs.data[i].position.x + inputs.data[i].dimensions.x);
+            bottom = max(bottom, inputs.data[i].position.y + inputs.data[i].dimensions.y);
+        }
+        column_count = (right + WIDGET_GRID_CELL_SIZE - 1) / WIDGET_GRID_CELL_SIZE;
+        row_count = (bottom + WIDGET_GRID_CELL_SIZE - 1) / WIDGET_GRID_CELL_SIZE;
+        auto cell_count = column_count * row_count;
+        cell_starts.clear();
+        for (u64 i = 0; i <= cell_count; i++)
+        {
+            cell_starts.push(0);
+        }
+
+        u64 total = 0;
+        for (u64 pass = 0; pass < 2; pass++)
+        {
+            for (u64 i = 0; i < inputs.size; i++)
+            {
+                auto input = &inputs.data[i];
+                if (input->dimensions.x == 0 || input->dimensions.y == 0)
+                {
+                    continue;
+                }
+                auto first_column = input->position.x / WIDGET_GRID_CELL_SIZE;
+                auto end_column = (input->position.x + input->dimensions.x - 1) / WIDGET_GRID_CELL_SIZE + 1;
+                auto first_row = input->position.y / WIDGET_GRID_CELL_SIZE;
+                auto end_row = (input->position.y + input->dimensions.y - 1) / WIDGET_GRID_CELL_SIZE + 1;
+                for (auto row = first_row; row < end_row; row++)
+                {
+                    for (auto column = first_column; column < end_column; column++)
+                    {
+                        auto cell = row * column_count + column;
+                        if (pass == 0)
+                        {
+                            cell_starts.data[cell + 1]++;
+                            total++;
+                        }
+                        else
+                        { // cell_starts[cell + 1] is where the cell's next index goes for now
+                            input_indices.data[cell_starts.data[cell + 1]++] = i;
+                        }
+                    }
+                }
+            }
+            if (pass == 0)
+            { // shifted by one: cell_starts[cell + 1] becomes where the cell starts, then where it ends once filled in
+                u64 offset = 0;
+                for (u64 cell = 0; cell <= cell_count; cell++)
+                {
+                    auto count = cell_starts.data[cell];
+                    cell_starts.data[cell] = offset;
+                    offset += count;
+                }
+                input_indices.clear();
+                for (u64 i = 0; i < total; i++)
+                {
+                    input_indices.push(0);
+                }
+            }
+        }
+    }
+
+    // the topmost input at `point`
+    Option<u64> find(List<InputState> inputs, Vector2<u64> point)
+    {
+        auto column = point.x / WIDGET_GRID_CELL_SIZE;
+        auto row = point.y / WIDGET_GRID_CELL_SIZE;
+        if (column >= column_count || row >= row_count)
+        {
+            return Option<u64>::empty();
+        }
+        auto cell = row * column_count + column;
+        for (auto i = cell_starts.data[cell + 1]; i > cell_starts.data[cell]; i--)
+        {
+            auto input_index = input_indices.data[i - 1];
+            auto input = &inputs.data[input_index];
+            if (point.x >= input->position.x && point.x < input->position.x + input->dimensions.x &&
+                point.y >= input->position.y && point.y < input->position.y + input->dimensions.y)
+            {
+                return Option<u64>::construct(input_index);
+            }
+        }
+        return Option<u64>::empty();
+    }
+};
+
+struct InputWidgets
+{
+    List<InputState> inputs;
+    u64 focused_index;
+    WidgetGrid grid;
+    bool is_grid_dirty;
+    // the input that had the focus when Ctrl+V was pressed during the last apply_events, and the press's time;
+    // the clipboard transfer that follows goes into that input, wherever the focus moves in the meantime
+    Option<u64> paste_input_index;
+    u32 paste_time;
+
+    static InputWidgets allocate()
+    {
+        InputWidgets result;
+        result.inputs = List<InputState>::allocate();
+        result.focused_index = 0;
+        result.grid = WidgetGrid::allocate();
+        result.is_grid_dirty = true;
+        result.paste_input_index = Option<u64>::empty();
+        result.paste_time = 0;
+        return result;
+    }
+
+    void deallocate()
+    {
+        for (u64 i = 0; i < inputs.size; i++)
+        {
+            inputs.data[i].text.deallocate();
+        }
+        inputs.deallocate();
+        grid.deallocate();
+    }
+
+    // the first input gets the focus
+    u64 add(InputState input)
+    {
+        input.is_in_focus = inputs.size == 0;
+        inputs.push(input);
+        is_grid_dirty = true;
+        return inputs.size - 1;
+    }
+
+    InputState* get_focused()
+    {
+        return &inputs.data[focused_index];
+    }
+
+    void focus(u64 index)
+    {
+        inputs.data[focused_index].is_in_focus = false;
+        focused_index = index;
+        inputs.data[index].is_in_focus = true;
+        inputs.data[index].timer = 0; // the cursor shows up right away
+    }
+
+    // has to be called after inputs were moved or resized
+    void on_layout_changed()
+    {
+        is_grid_dirty = true;
+    }
+
+    // in order, so that keys typed before a click in the same frame still go where the focus was
+    void apply_events(List<X11Event> events)
+    {
+        paste_input_index = Option<u64>::empty();
+        if (is_grid_dirty)
+        {
+            grid.build(inputs);
+            is_grid_dirty = false;
+        }
+        for (u64 i = 0; i < events.size; i++)
+        {
+            auto event = &events.data[i];
+            if (event->type == X11EventTypeButtonPress)
+            {
+                auto button_press = (X11EventKeyPress*)event; // same layout, key_code is the button
+                if ((X11Button)button_press->key_code != X11ButtonLeft || button_press->event_x < 0 || button_press->event_y < 0)
+                {
+                    continue;
+                }
+                auto maybe_index = grid.find(inputs, Vector2<u64>::construct(button_press->event_x, button_press->event_y));
+                if (maybe_index.has_data && maybe_index.value != focused_index)
+                {
+                    focus(maybe_index.value);
+                }
+                continue;
+            }
+            if (event->type != X11EventTypeKeyPress || inputs.size == 0)
+            {
+                continue;
+            }
+            auto key_press = (X11EventKeyPress*)event;
+            if (key_press->key_code == X11KeyCodeTab)
+            {
+                auto is_backward = (key_press->state & X11ModifierKeyShift) != 0;
+                focus((focused_index + (is_backward ? inputs.size - 1 : 1)) % inputs.size);
+                continue;
+            }
+            if (key_press->key_code == X11KeyCodeV && (key_press->state & X11ModifierKeyControl))
+            {
+                paste_input_index = Option<u64>::construct(focused_index);
+                paste_time = key_press->time;
+                continue;
+            }
+            List<X11Event> key_events;
+            key_events.data = event;
+            key_events.size = 1;
+            apply_input_events(get_focused(), key_events);
+        }
+    }
+
+    void render(List<X11Event> events, ImageView image)
+    {
+        apply_events(events);
+        List<X11Event> no_events; // every input's events were applied above
+        no_events.data = nullptr;
+        no_events.size = 0;
+        for (u64 i = 0; i < inputs.size; i++)
+        {
+            if (inputs.data[i].has_room_for_text())
+            {
+                render_input(&inputs.data[i], no_events, image);
+            }
+        }
+    }
+};
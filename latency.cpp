@@ -0,0 +1,176 @@
+// input-to-screen latency: every frame that input went into gets a round-trip fence after its image upload,
+// and when the fence's reply is in, the time since the oldest of that input arrived is recorded
+
+const u64 LATENCY_HISTOGRAM_SUB_BUCKET_BITS = 5; // 32 sub-buckets per power of two, values are off by under 3%
+const u64 LATENCY_HISTOGRAM_SUB_BUCKET_COUNT = 1 << LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+const u64 LATENCY_HISTOGRAM_BUCKET_COUNT = (64 - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1) * LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+
+// log-linear buckets like in HdrHistogram; recording is a couple of atomic adds, so any thread can record
+// into it without locking, and reading it while that happens only skews the result by the samples in flight
+struct LatencyHistogram
+{
+    u64 counts[LATENCY_HISTOGRAM_BUCKET_COUNT];
+    u64 total_count;
+    u64 max_value;
+
+    static u64 get_bucket(u64 value)
+    {
+        if (value < LATENCY_HISTOGRAM_SUB_BUCKET_COUNT)
+        {
+            return value;
+        }
+        u64 shift = 63 - __builtin_clzll(value) - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+        return (shift + 1) * LATENCY_HISTOGRAM_SUB_BUCKET_COUNT + (value >> shift) - LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+    }
+
+    // the highest value that falls into the bucket
+    static u64 get_bucket_value(u64 bucket)
+    {
+        if (bucket < LATENCY_HISTOGRAM_SUB_BUCKET_COUNT)
+        {
+            return bucket;
+        }
+        auto shift = bucket / LATENCY_HISTOGRAM_SUB_BUCKET_COUNT - 1;
+        auto sub_bucket = bucket % LATENCY_HISTOGRAM_SUB_BUCKET_COUNT + LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+        return ((sub_bucket + 1) << shift) - 1;
+    }
+
+    void record(u64 value)
+    {
+        __atomic_fetch_add(&counts[get_bucket(value)], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&total_count, 1, __ATOMIC_RELAXED);
+        auto current_max = __atomic_load_n(&max_value, __ATOMIC_RELAXED);
+        while (value > current_max && !__atomic_compare_exchange_n(&max_value, &current_max, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+        }
+    }
+
+    // the value below which numerator / denominator of the samples are, e.g. 999 / 1000 for p99.9
+    u64 get_quantile(u64 numerator, u64 denominator)
+    {
+        auto total = __atomic_load_n(&total_count, __ATOMIC_RELAXED);
+        if (total == 0)
+        {
+            return 0;
+        }
+        auto rank = max((total * numerator + denominator - 1) / denominator, (u64)1);
+        u64 seen = 0;
+        for (u64 bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKET_COUNT; bucket++)
+        {
+            seen += __atomic_load_n(&counts[bucket], __ATOMIC_RELAXED);
+            if (seen >= rank)
+            {
+                return min(get_bucket_value(bucket), __atomic_load_n(&max_value, __ATOMIC_RELAXED));
+            }
+        }
+        return __atomic_load_n(&max_value, __ATOMIC_RELAXED);
+    }
+
+    // values are in nanoseconds, printed in microseconds
+    void print_summary(CStringView name)
+    {
+        print(
+            name, ": ", total_count, " samples",
+            ", p50 ", get_quantile(1, 2) / 1000, " us",
+            ", p99 ", get_quantile(99, 100) / 1000, " us",
+            ", p999 ", get_quantile(999, 1000) / 1000, " us",
+            ", max ", max_value / 1000, " us\n"
+        );
+    }
+};
+
+alignas(64) LatencyHistogram input_latency_histogram; // zeroed, in .bss
+
+struct LatencyFence
+{
+    u16 sequence_number;
+    u64 input_time; // of the oldest input that the fenced frame shows
+};
+
+struct InputLatencyTracker
+{
+    LatencyHistogram* histogram;
+    // the server's clock (milliseconds, its own epoch) is mapped onto ours by the smallest difference seen
+    // between the two, which is as close to zero transport delay as we can tell
+    bool has_clock_offset;
+    s64 clock_offset; // in milliseconds
+    u64 frame_input_time; // 0 if no input went into the current frame yet
+    List<LatencyFence> fences; // in the order they were sent, which is the order their replies arrive in
+    u64 first_pending_fence;
+
+    static InputLatencyTracker construct(LatencyHistogram* histogram)
+    {
+        InputLatencyTracker result;
+        result.histogram = histogram;
+        result.has_clock_offset = false;
+        result.clock_offset = 0;
+        result.frame_input_time = 0;
+        result.fences = List<LatencyFence>::allocate();
+        result.first_pending_fence = 0;
+        return result;
+    }
+
+    void deallocate()
+    {
+        fences.deallocate();
+    }
+
+    // `arrival_time` is when the event was read off the socket; the event's own timestamp tells how long it was
+    // queued before that, e.g. while we were asleep between frames
+    void on_event(X11Event* event, u64 arrival_time)
+    {
+        if (event->type != X11EventTypeKeyPress && event->type != X11EventTypeButtonPress)
+        {
+            return;
+        }
+        auto server_time = ((X11EventKeyPress*)event)->time; // button presses have the same layout
+        auto arrival_milliseconds = arrival_time / (1000 * 1000);
+        auto offset = (s64)arrival_milliseconds - server_time;
+        if (!has_clock_offset || offset < clock_offset)
+        {
+            has_clock_offset = true;
+            clock_offset = offset;
+        }
+        auto queued_time = (u64)(offset - clock_offset) * 1000 * 1000;
+        auto input_time = queued_time < arrival_time ? arrival_time - queued_time : arrival_time;
+        if (frame_input_time == 0 || input_time < frame_input_time)
+        {
+            frame_input_time = input_time;
+        }
+    }
+
+    // call after the frame's image was sent
+    void on_frame_sent(X11Connection* connection)
+    {
+        if (frame_input_time == 0)
+        {
+            return;
+        }
+        X11GetInputFocusRequest request;
+        request.type = X11RequestTypeGetInputFocus;
+        request.request_size_in_dwords = sizeof(request) / 4;
+        LatencyFence fence;
+        fence.sequence_number = connection->send_request("get input focus", &request, sizeof(request));
+        fence.input_time = frame_input_time;
+        fences.push(fence);
+        frame_input_time = 0;
+    }
+
+    // returns false if the reply isn't a fence; fence replies have no body past the first 32 bytes
+    bool handle_reply(X11Event* reply)
+    {
+        auto sequence_number = *(u16*)(reply->data + 1);
+        if (first_pending_fence == fences.size || fences.data[first_pending_fence].sequence_number != sequence_number)
+        {
+            return false;
+        }
+        histogram->record(get_monotonic_time() - fences.data[first_pending_fence].input_time);
+        first_pending_fence++;
+        if (first_pending_fence == fences.size)
+        {
+            fences.clear();
+            first_pending_fence = 0;
+        }
+        return true;
+    }
+};
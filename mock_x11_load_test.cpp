@@ -0,0 +1,233 @@
+// runs the client's frame loop unpaced against the mock X server in a child process, over a socket pair;
+// reports the client's frame rate and upload bandwidth, the input latency as the client sees it,
+// whether a big paste arrived whole in the input it was meant for, and what the server received
+
+#include <mystd/include_linux.h>
+
+#pragma pack(push, 1)
+
+#include "syscalls.cpp"
+#include "profiler.cpp"
+#include "arena.cpp"
+#include "page_allocator.cpp"
+#include "utf8.cpp"
+#include "codepoint_map.cpp"
+#include "byte_search.cpp"
+#include "x11.cpp"
+#include "x11_trace.cpp"
+#include "x11_connection.cpp"
+#include "renderer.cpp"
+#include "blit.cpp"
+#include "text_renderer.cpp"
+#include "gap_buffer.cpp"
+#include "input_renderer.cpp"
+#include "input_widgets.cpp"
+#include "clipboard.cpp"
+#include "latency.cpp"
+#include "text_search.cpp"
+#include "document_view.cpp"
+#include "x11_client.cpp"
+#include "app.cpp"
+#include "backend.cpp"
+#include "mock_x11_server.cpp"
+
+const u64 LOAD_TEST_FRAME_COUNT = 500;
+const u64 LOAD_TEST_WINDOW_COUNT = 4; // all of them on the one connection, each with its own framebuffer
+const bool LOAD_TEST_IS_TRACED = false; // writes x11_trace.bin, for x11_trace_decode.bin
+const u64 LOAD_TEST_PASTE_WINDOW_INDEX = 0; // the mock server presses Ctrl+V in its first window
+
+// bytes of the paste that aren't where they belong: the pasted text has to make up the end of the input's text
+u64 count_misplaced_paste_bytes(InputState* input, u64 paste_size)
+{
+    auto before_caret = input->text.get_before_caret();
+    auto after_caret = input->text.get_after_caret();
+    auto size = before_caret.size + after_caret.size;
+    if (size < paste_size)
+    {
+        return paste_size;
+    }
+    auto pattern_size = get_c_string_length(MOCK_X11_PASTE_TEXT);
+    u64 result = 0;
+    for (u64 i = 0; i < paste_size; i++)
+    {
+        auto offset = size - paste_size + i;
+        auto character = offset < before_caret.size ? before_caret.data[offset] : after_caret.data[offset - before_caret.size];
+        result += character != MOCK_X11_PASTE_TEXT[i % pattern_size];
+    }
+    return result;
+}
+
+MockX11ServerConfig get_load_test_server_config()
+{
+    MockX11ServerConfig result;
+    result.expose_interval = 100 * 1000 * 1000;
+    result.key_press_interval = 5 * 1000 * 1000;
+    result.resize_interval = 20 * 1000 * 1000;
+    result.resize_burst_size = 8;
+    result.latency = 1000 * 1000;
+    result.bandwidth = 0;
+    result.paste_delay = 50 * 1000 * 1000;
+    result.paste_size = 100 * 1024 * 1024;
+    result.paste_chunk_size = CLIPBOARD_CHUNK_SIZE_IN_DWORDS * 4;
+    return result;
+}
+
+extern "C" void _start()
+{
+    Descriptor client_socket;
+    Descriptor server_socket;
+    assert(create_socket_pair(&client_socket, &server_socket), "Failed to create a socket pair");
+    auto server_pid = fork_process();
+    assert(server_pid >= 0, "Failed to fork the mock server");
+    if (server_pid == 0)
+    {
+        close(client_socket);
+        auto server = MockX11Server::construct(server_socket, get_load_test_server_config());
+        server.serve();
+        server.print_stats();
+        server.deallocate();
+        close(server_socket);
+        exit(0);
+    }
+    close(server_socket);
+
+    byte cookie[MIT_COOKIE_SIZE] = {};
+    auto x11_connection = x11_handshake(client_socket, cookie);
+    auto backend = RenderBackend::construct_x11(&x11_connection);
+    auto graphics_context_id = create_x11_graphics_context(&x11_connection);
+    auto windows = List<AppWindow>::allocate();
+    for (u64 i = 0; i < LOAD_TEST_WINDOW_COUNT; i++)
+    {
+        backend.add_window(create_x11_window(&x11_connection, graphics_context_id));
+        windows.push(AppWindow::allocate(WINDOW_WIDTH, WINDOW_HEIGHT, /* document: */ nullptr));
+    }
+    for (u64 i = 0; i < LOAD_TEST_WINDOW_COUNT; i++)
+    {
+        x11_connection.wait_for_expose(backend.windows.data[i].id);
+    }
+    auto clipboard_paste = ClipboardPaste::construct(&x11_connection);
+    auto latency_tracker = InputLatencyTracker::construct(&input_latency_histogram);
+    auto events = List<X11Event>::allocate();
+    u64 paste_frame_count = 0;
+    u64 longest_paste_frame_time = 0;
+    u64 event_count = 0;
+    u64 uploaded_size = 0;
+    u64 reallocation_count = 0; // of framebuffers, while resizing
+    X11Trace x11_trace = {};
+    if (LOAD_TEST_IS_TRACED)
+    {
+        x11_trace = X11Trace::open("x11_trace.bin").unwrap("Failed to open the trace file");
+        x11_connection.trace = &x11_trace;
+    }
+
+    auto start_time = get_monotonic_time();
+    for (u64 frame = 0; frame < LOAD_TEST_FRAME_COUNT; frame++)
+    {
+        auto frame_start_time = get_monotonic_time();
+        auto was_pasting = clipboard_paste.state != ClipboardPasteStateIdle;
+        for (u64 i = 0; i < x11_connection.pending_events.size; i++)
+        {
+            events.push(x11_connection.pending_events.data[i]);
+        }
+        x11_connection.pending_events.clear();
+        while (true)
+        {
+            PollParameter poll_parameter;
+            poll_parameter.descriptor = x11_connection.socket;
+            poll_parameter.requested_events = PollEventDataAvailable;
+            auto poll_result = poll(&poll_parameter, /* count: */ 1, POLL_TIMEOUT_RETURN_IMMEDIATELY);
+            assert(poll_result >= 0, "Failed to poll X11 socket for events");
+            if (poll_result == 0)
+            {
+                break;
+            }
+            X11Event event_buffer;
+            x11_connection.read_message(&event_buffer);
+            if (event_buffer.type == X11EventTypeReply)
+            {
+                auto paste_window = backend.find_window(clipboard_paste.window_id);
+                auto paste_input = paste_window.has_data ? &windows.data[paste_window.value].inputs.inputs.data[clipboard_paste.input_index] : nullptr;
+                if (!clipboard_paste.handle_reply(&x11_connection, &event_buffer, paste_input) && !latency_tracker.handle_reply(&event_buffer))
+                {
+                    x11_connection.skip_bytes(*(u32*)(event_buffer.data + 3) * 4);
+                }
+                continue;
+            }
+            latency_tracker.on_event(&event_buffer, get_monotonic_time());
+            events.push(event_buffer);
+        }
+        event_count += events.size;
+        clipboard_paste.handle_events(&x11_connection, events);
+        clipboard_paste.update(&x11_connection);
+        for (u64 i = 0; i < events.size; i++)
+        {
+            auto window_index = backend.find_window(get_x11_event_window_id(&events.data[i]));
+            if (window_index.has_data)
+            {
+                windows.data[window_index.value].events.push(events.data[i]);
+            }
+        }
+
+        for (u64 i = 0; i < windows.size; i++)
+        {
+            auto previous_data = windows.data[i].image.data;
+            windows.data[i].render();
+            reallocation_count += windows.data[i].image.data != previous_data;
+            backend.present(windows.data[i].image, i);
+            auto paste_input_index = windows.data[i].inputs.paste_input_index;
+            if (paste_input_index.has_data)
+            {
+                clipboard_paste.start(&x11_connection, backend.windows.data[i].id, paste_input_index.value, windows.data[i].inputs.paste_time);
+            }
+            uploaded_size += windows.data[i].image.stride * windows.data[i].image.height * sizeof(Pixel);
+            windows.data[i].events.clear();
+        }
+        latency_tracker.on_frame_sent(&x11_connection);
+        x11_connection.flush(); // what backend.end_frame does, without the pacing
+        events.clear();
+        if (x11_connection.trace != nullptr)
+        {
+            x11_trace.record_frame_end(x11_connection.last_sequence_number);
+            x11_trace.flush_slice();
+        }
+        if (was_pasting || clipboard_paste.state != ClipboardPasteStateIdle)
+        {
+            paste_frame_count++;
+            longest_paste_frame_time = max(longest_paste_frame_time, get_monotonic_time() - frame_start_time);
+        }
+    }
+    auto elapsed_time = get_monotonic_time() - start_time;
+
+    print(
+        "client: ", LOAD_TEST_FRAME_COUNT, " frames of ", LOAD_TEST_WINDOW_COUNT, " windows in ", elapsed_time / 1000, " us, ",
+        LOAD_TEST_FRAME_COUNT * 1000 * 1000 * 1000 / elapsed_time, " frames/s, ",
+        uploaded_size * 1000 / elapsed_time, " MB/s uploaded, ",
+        event_count, " events, ", reallocation_count, " framebuffer reallocations\n"
+    );
+    print("client framebuffers: ", get_page_mode_name(windows.data[0].image.pages.mode), windows.data[0].image.pages.is_locked ? ", locked\n" : "\n");
+    input_latency_histogram.print_summary("client input latency");
+    auto server_config = get_load_test_server_config();
+    auto paste_input = &windows.data[LOAD_TEST_PASTE_WINDOW_INDEX].inputs.inputs.data[0]; // focused when Ctrl+V came
+    print(
+        "client paste: ", server_config.paste_size, " bytes into window ", LOAD_TEST_PASTE_WINDOW_INDEX, "'s first input, ",
+        count_misplaced_paste_bytes(paste_input, server_config.paste_size), " of them missing or wrong, ",
+        clipboard_paste.state == ClipboardPasteStateIdle ? "" : "still going, ",
+        paste_frame_count, " frames while pasting, the longest took ", longest_paste_frame_time / 1000, " us\n"
+    );
+
+    if (x11_connection.trace != nullptr)
+    {
+        x11_trace.close_file();
+    }
+    events.deallocate();
+    latency_tracker.deallocate();
+    for (u64 i = 0; i < windows.size; i++)
+    {
+        windows.data[i].deallocate();
+    }
+    windows.deallocate();
+    backend.dispose();
+    x11_connection.dispose();
+    wait_for_process(server_pid);
+    exit(0);
+}
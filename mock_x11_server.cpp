@@ -0,0 +1,609 @@
+// a fake X server that speaks just enough of the protocol for this client: the handshake, the requests the
+// client sends and their replies, plus synthetic Expose, KeyPress and ConfigureNotify events at configurable rates,
+// and optionally a CLIPBOARD selection that is pasted into the first window and handed over with INCR;
+// it can hold every outgoing message back by a fixed latency and read requests no faster than a given bandwidth,
+// and it counts what it receives, so the transport can be load-tested without a display
+
+const u32 MOCK_X11_BASE_ID = 0x04000000;
+const u32 MOCK_X11_ID_MASK = 0x001FFFFF;
+const u32 MOCK_X11_ROOT_WINDOW_ID = 0x000001E0;
+const u32 MOCK_X11_ROOT_VISUAL_ID = 0x00000021;
+const X11Atom MOCK_X11_FIRST_ATOM = 0x100; // the predefined atoms are below this
+const u64 MOCK_X11_IDLE_SLEEP = 100 * 1000; // in nanoseconds, when there's nothing to read or send
+const u64 MOCK_X11_PASTE_PIECE_SIZE = 64 * 1024; // of the pasted text, per send
+
+// repeated to make up the pasted text; its sequences end up split across chunks, and it has no '?' in it, so text
+// that gets replaced on the way shows up
+CStringView MOCK_X11_PASTE_TEXT = "pasted text, with a few non-ASCII characters: \xC3\xBC\xC3\xB1\xC3\xAF \xE2\x82\xAC \xF0\x9F\x93\x8B; ";
+
+struct MockX11ServerConfig
+{
+    u64 expose_interval; // in nanoseconds, 0 for only the Expose after MapWindow
+    u64 key_press_interval; // in nanoseconds, 0 for none
+    u64 resize_interval; // in nanoseconds, 0 for none
+    u64 resize_burst_size; // ConfigureNotify per window every resize_interval, like an interactive resize sends
+    u64 latency; // in nanoseconds, added to every reply and event
+    u64 bandwidth; // in bytes per second that requests are read at, 0 for unlimited
+    u64 paste_delay; // in nanoseconds, when Ctrl+V is pressed in the first window
+    u64 paste_size; // in bytes, of the CLIPBOARD selection, 0 for no selection owner and no Ctrl+V
+    u64 paste_chunk_size; // in bytes, per INCR chunk
+};
+
+struct MockX11ServerStats
+{
+    u64 bytes_received;
+    u64 bytes_sent;
+    u64 request_count;
+    u64 request_counts[128]; // by X11RequestType
+    u64 image_bytes_received; // PutImage data, without the request headers
+    u64 events_sent;
+    u64 replies_sent;
+};
+
+struct MockX11OutgoingMessage
+{
+    u64 send_time;
+    X11Event message; // the first 32 bytes of replies
+    u64 extra_size; // of a reply, in bytes after the first 32, that many bytes of it are sent after the message
+    u64 text_size; // the first text_size bytes of the extra are the pasted text from text_offset on
+    u64 text_offset;
+    u32 value; // the at most 4 bytes of the extra after the text, like INCR's size or the text's padding
+};
+
+// the pasted text from any offset is a contiguous piece of this, as long as it's at most MOCK_X11_PASTE_PIECE_SIZE
+byte mock_x11_paste_pattern[MOCK_X11_PASTE_PIECE_SIZE * 2];
+
+struct MockX11Server
+{
+    Descriptor socket;
+    MockX11ServerConfig config;
+    MockX11ServerStats stats;
+    u16 sequence_number; // of the last request received
+    List<u32> window_ids; // in creation order
+    X11Atom next_atom;
+    List<MockX11OutgoingMessage> outgoing; // in send_time order, because latency is the same for all of them
+    u64 first_outgoing;
+    u64 start_time;
+    u64 next_expose_time;
+    u64 next_key_press_time;
+    u64 key_press_count;
+    u64 next_resize_time;
+    u64 resize_count;
+    u64 outgoing_sent_size; // of the first outgoing message, which can go out over several calls
+
+    X11Atom incr_atom; // whatever the client interned "INCR" as
+    bool is_paste_pressed;
+    bool is_pasting; // a ConvertSelection was answered and the transfer isn't done
+    bool is_paste_incremental; // the INCR reply was sent, chunks go out from now on
+    u32 paste_window_id;
+    X11Atom paste_property;
+    X11Atom paste_target;
+    u64 paste_offset; // in the pasted text, of the next chunk
+
+    static MockX11Server construct(Descriptor socket, MockX11ServerConfig config)
+    {
+        MockX11Server result = {};
+        result.socket = socket;
+        result.config = config;
+        result.next_atom = MOCK_X11_FIRST_ATOM;
+        result.outgoing = List<MockX11OutgoingMessage>::allocate();
+        result.window_ids = List<u32>::allocate();
+        auto pattern_size = get_c_string_length(MOCK_X11_PASTE_TEXT);
+        for (u64 i = 0; i < sizeof(mock_x11_paste_pattern); i++)
+        {
+            mock_x11_paste_pattern[i] = MOCK_X11_PASTE_TEXT[i % pattern_size];
+        }
+        return result;
+    }
+
+    void deallocate()
+    {
+        outgoing.deallocate();
+        window_ids.deallocate();
+    }
+
+    // false once the client has hung up
+    bool read_exactly(void* buffer, u64 size)
+    {
+        u64 bytes_read = 0;
+        while (bytes_read != size)
+        {
+            auto read_result = read(socket, (byte*)buffer + bytes_read, size - bytes_read);
+            if (read_result <= 0)
+            {
+                return false;
+            }
+            bytes_read += read_result;
+        }
+        stats.bytes_received += size;
+        throttle();
+        return true;
+    }
+
+    // sleeps for as long as it takes for everything received so far to have arrived at the configured bandwidth
+    void throttle()
+    {
+        if (config.bandwidth == 0)
+        {
+            return;
+        }
+        const u64 second = 1000 * 1000 * 1000;
+        auto arrival_time = start_time
+            + stats.bytes_received / config.bandwidth * second
+            + stats.bytes_received % config.bandwidth * second / config.bandwidth;
+        auto now = get_monotonic_time();
+        if (arrival_time > now)
+        {
+            SleepTime sleep_time;
+            sleep_time.seconds = (arrival_time - now) / (1000 * 1000 * 1000);
+            sleep_time.nanoseconds = (arrival_time - now) % (1000 * 1000 * 1000);
+            nanosleep(&sleep_time);
+        }
+    }
+
+    // false once the client has hung up
+    bool write_all(void* data, u64 size)
+    {
+        auto write_result = send_without_signal(socket, data, size);
+        if (write_result != (s64)size)
+        {
+            return false;
+        }
+        stats.bytes_sent += size;
+        return true;
+    }
+
+    void send_later(X11Event message, u64 extra_size = 0, u64 text_size = 0, u64 text_offset = 0, u32 value = 0)
+    {
+        assert(extra_size <= text_size + sizeof(value), "MockX11Server::send_later: too much extra for the text");
+        MockX11OutgoingMessage outgoing_message;
+        outgoing_message.send_time = get_monotonic_time() + config.latency;
+        outgoing_message.message = message;
+        *(u16*)(outgoing_message.message.data + 1) = sequence_number;
+        outgoing_message.extra_size = extra_size;
+        outgoing_message.text_size = text_size;
+        outgoing_message.text_offset = text_offset;
+        outgoing_message.value = value;
+        outgoing.push(outgoing_message);
+    }
+
+    // as much of the message as the socket takes without blocking, from where the last call left off: the client
+    // can be busy writing a frame to us while a big reply is on its way, waiting for it would deadlock;
+    // false once the client has hung up
+    bool send_some(MockX11OutgoingMessage* message, bool* is_sent)
+    {
+        *is_sent = false;
+        auto pattern_size = get_c_string_length(MOCK_X11_PASTE_TEXT);
+        while (outgoing_sent_size < sizeof(X11Event) + message->extra_size)
+        {
+            byte* data;
+            u64 size;
+            if (outgoing_sent_size < sizeof(X11Event))
+            {
+                data = (byte*)&message->message + outgoing_sent_size;
+                size = sizeof(X11Event) - outgoing_sent_size;
+            }
+            else if (outgoing_sent_size - sizeof(X11Event) < message->text_size)
+            {
+                auto sent_text_size = outgoing_sent_size - sizeof(X11Event);
+                data = mock_x11_paste_pattern + (message->text_offset + sent_text_size) % pattern_size;
+                size = min(message->text_size - sent_text_size, MOCK_X11_PASTE_PIECE_SIZE);
+            }
+            else
+            {
+                auto sent_value_size = outgoing_sent_size - sizeof(X11Event) - message->text_size;
+                data = (byte*)&message->value + sent_value_size;
+                size = sizeof(X11Event) + message->extra_size - outgoing_sent_size;
+            }
+            auto send_result = send_without_blocking(socket, data, size);
+            if (send_result == LINUX_ERROR_AGAIN)
+            {
+                return true;
+            }
+            if (send_result <= 0)
+            {
+                return false;
+            }
+            outgoing_sent_size += send_result;
+            stats.bytes_sent += send_result;
+        }
+        outgoing_sent_size = 0;
+        *is_sent = true;
+        return true;
+    }
+
+    // the server's timestamps are milliseconds since it started
+    u32 get_server_time()
+    {
+        return (get_monotonic_time() - start_time) / (1000 * 1000);
+    }
+
+    bool handle_handshake()
+    {
+        X11ConnectionRequest request_start; // only the fixed part, the sizes of the rest are in it
+        if (!read_exactly(&request_start, 12))
+        {
+            return false;
+        }
+        assert(request_start.order == X11EndiannessLittle, "MockX11Server: only little-endian clients are supported");
+        auto name_size = request_start.authorization_protocol_name_size;
+        auto data_size = request_start.authorization_protocol_data_size;
+        byte authorization[256];
+        auto authorization_size = name_size + x11_calculate_padding(name_size) + data_size + x11_calculate_padding(data_size);
+        assert(authorization_size <= sizeof(authorization), "MockX11Server: authorization data is too long");
+        if (!read_exactly(authorization, authorization_size))
+        {
+            return false;
+        }
+        // any cookie is accepted
+
+        const char vendor[] = "mock"; // a multiple of 4 long, so no padding
+        const u64 vendor_size = sizeof(vendor) - 1;
+        byte body[sizeof(X11ConnectionResponseBodyInitial) + vendor_size + 8 + 40 + 8 + 24] = {};
+        auto initial = (X11ConnectionResponseBodyInitial*)body;
+        initial->release = 1;
+        initial->base_id = MOCK_X11_BASE_ID;
+        initial->id_mask = MOCK_X11_ID_MASK;
+        initial->vendor_len = vendor_size;
+        initial->request_max = 0xFFFF;
+        initial->num_screens = 1;
+        initial->num_pixmap_formats = 1;
+        initial->scanline_unit = 32;
+        initial->scanline_pad = 32;
+        initial->keycode_min = 8;
+        initial->keycode_max = 255;
+        auto cursor = body + sizeof(X11ConnectionResponseBodyInitial);
+        copy_memory(vendor, vendor_size, cursor);
+        cursor += vendor_size;
+        // pixmap format: depth, bits per pixel, scanline pad
+        cursor[0] = DEPTH;
+        cursor[1] = 32;
+        cursor[2] = 32;
+        cursor += 8;
+        // screen
+        *(u32*)(cursor + 0) = MOCK_X11_ROOT_WINDOW_ID;
+        *(u32*)(cursor + 16) = 0x00FFFFFF; // white pixel
+        *(u16*)(cursor + 20) = WINDOW_WIDTH * 2;
+        *(u16*)(cursor + 22) = WINDOW_HEIGHT * 2;
+        *(u32*)(cursor + 32) = MOCK_X11_ROOT_VISUAL_ID;
+        cursor[38] = DEPTH; // root depth
+        cursor[39] = 1; // number of allowed depths
+        cursor += 40;
+        // depth, with one visual
+        cursor[0] = DEPTH;
+        *(u16*)(cursor + 2) = 1;
+        cursor += 8;
+        *(u32*)(cursor + 0) = MOCK_X11_ROOT_VISUAL_ID;
+        cursor[4] = 4; // TrueColor
+        cursor[5] = 8; // bits per RGB value
+        *(u32*)(cursor + 12) = 0x00FF0000;
+        *(u32*)(cursor + 16) = 0x0000FF00;
+        *(u32*)(cursor + 20) = 0x000000FF;
+
+        X11ConnectionResponseHeader header = {};
+        header.status = X11ConnectionStatusSuccess;
+        header.major_version = 11;
+        header.body_size_in_dwords = sizeof(body) / 4;
+        return write_all(&header, sizeof(header)) && write_all(body, sizeof(body));
+    }
+
+    void send_expose(u32 window_id)
+    {
+        X11Event event = {};
+        auto expose = (X11EventExpose*)&event;
+        expose->type = X11EventTypeExpose;
+        expose->window_id = window_id;
+        expose->width = WINDOW_WIDTH;
+        expose->height = WINDOW_HEIGHT;
+        send_later(event);
+        stats.events_sent++;
+    }
+
+    // the size goes back and forth between half and all of the initial size, a step per event
+    void send_configure_notify(u32 window_id)
+    {
+        auto step = resize_count % 100;
+        auto percent = 50 + (step < 50 ? step : 100 - step);
+        X11Event event = {};
+        auto configure_notify = (X11EventConfigureNotify*)&event;
+        configure_notify->type = X11EventTypeConfigureNotify;
+        configure_notify->event_window_id = window_id;
+        configure_notify->window_id = window_id;
+        configure_notify->width = WINDOW_WIDTH * percent / 100;
+        configure_notify->height = WINDOW_HEIGHT * percent / 100;
+        send_later(event);
+        stats.events_sent++;
+        resize_count++;
+    }
+
+    void send_key_press(u32 window_id, X11KeyCode key_code, X11ModifierKey modifiers = (X11ModifierKey)0)
+    {
+        X11Event event = {};
+        auto key_press = (X11EventKeyPress*)&event;
+        key_press->type = X11EventTypeKeyPress;
+        key_press->key_code = key_code;
+        key_press->time = get_server_time();
+        key_press->window_id = MOCK_X11_ROOT_WINDOW_ID;
+        key_press->event = window_id;
+        key_press->state = modifiers;
+        key_press->same_screen = true;
+        send_later(event);
+        stats.events_sent++;
+    }
+
+    // the windows take turns getting the key presses
+    void send_next_key_press()
+    {
+        auto window_id = window_ids.data[key_press_count % window_ids.size];
+        X11KeyCode letters[] = {X11KeyCodeH, X11KeyCodeE, X11KeyCodeL, X11KeyCodeL, X11KeyCodeO, X11KeyCodeSpace, X11KeyCodeBackspace};
+        send_key_press(window_id, letters[key_press_count % (sizeof(letters) / sizeof(letters[0]))]);
+        key_press_count++;
+    }
+
+    void send_property_notify(u32 window_id, X11Atom property, X11PropertyState state)
+    {
+        X11Event event = {};
+        auto property_notify = (X11EventPropertyNotify*)&event;
+        property_notify->type = X11EventTypePropertyNotify;
+        property_notify->window_id = window_id;
+        property_notify->property = property;
+        property_notify->time = get_server_time();
+        property_notify->state = state;
+        send_later(event);
+        stats.events_sent++;
+    }
+
+    // the selection is converted by announcing INCR, then every GetProperty after the client deleted the property
+    // gets the next chunk, and the chunk after it is announced right away, until an empty one ends the transfer;
+    // the focus moves on with a Tab while the first chunk is on its way, the rest still belongs where Ctrl+V was
+    void send_paste_property(X11GetPropertyRequest* request)
+    {
+        X11Event reply = {};
+        auto header = (X11GetPropertyReplyHeader*)&reply;
+        if (!is_paste_incremental)
+        {
+            header->format = 32;
+            header->reply_size_in_dwords = 1;
+            header->property_type = incr_atom;
+            header->value_count = 1; // a lower bound of the size, this owner knows it exactly
+            send_reply(reply, 4, 0, 0, config.paste_size);
+            is_paste_incremental = true;
+            return;
+        }
+        auto chunk_size = min(min(config.paste_chunk_size, config.paste_size - paste_offset), (u64)request->size_in_dwords * 4);
+        header->format = 8;
+        header->reply_size_in_dwords = (chunk_size + 3) / 4;
+        header->property_type = paste_target;
+        header->value_count = chunk_size;
+        send_reply(reply, header->reply_size_in_dwords * 4, chunk_size, paste_offset);
+        if (paste_offset == 0)
+        {
+            send_key_press(paste_window_id, X11KeyCodeTab);
+        }
+        paste_offset += chunk_size;
+        if (chunk_size == 0)
+        {
+            is_pasting = false;
+            return;
+        }
+        send_property_notify(paste_window_id, paste_property, X11PropertyStateNewValue);
+    }
+
+    void send_reply(X11Event reply, u64 extra_size = 0, u64 text_size = 0, u64 text_offset = 0, u32 value = 0)
+    {
+        reply.type = X11EventTypeReply;
+        send_later(reply, extra_size, text_size, text_offset, value);
+        stats.replies_sent++;
+    }
+
+    bool handle_request()
+    {
+        // the start of the request is kept for the requests that need it, the rest is only counted
+        const u64 header_size = 4;
+        byte request_start[64];
+        if (!read_exactly(request_start, header_size))
+        {
+            return false;
+        }
+        auto type = (X11RequestType)request_start[0];
+        u64 size = *(u16*)(request_start + 2) * 4;
+        assert(size >= header_size, "MockX11Server: zero-length requests (BIG-REQUESTS) aren't supported");
+        sequence_number++;
+        stats.request_count++;
+        stats.request_counts[(u8)type & 127]++;
+
+        auto kept_size = min(size, (u64)sizeof(request_start));
+        if (!read_exactly(request_start + header_size, kept_size - header_size))
+        {
+            return false;
+        }
+        byte discarded[64 * 1024];
+        for (auto remaining = size - kept_size; remaining != 0;)
+        {
+            auto chunk_size = min(remaining, (u64)sizeof(discarded));
+            if (!read_exactly(discarded, chunk_size))
+            {
+                return false;
+            }
+            remaining -= chunk_size;
+        }
+
+        X11Event reply = {};
+        switch (type)
+        {
+            case X11RequestTypeCreateWindow: window_ids.push(((X11CreateWindowRequestHeader*)request_start)->window_id); break;
+            case X11RequestTypeMapWindow: send_expose(((X11MapWindowRequest*)request_start)->window_id); break;
+            case X11RequestTypePutImage: stats.image_bytes_received += size - sizeof(X11PutImageRequestHeader); break;
+            case X11RequestTypeInternAtom:
+            {
+                auto request = (X11InternAtomRequestHeader*)request_start;
+                auto name = (char*)(request_start + sizeof(X11InternAtomRequestHeader));
+                if (request->name_size == 4 && name[0] == 'I' && name[1] == 'N' && name[2] == 'C' && name[3] == 'R')
+                {
+                    incr_atom = next_atom;
+                }
+                ((X11InternAtomReply*)&reply)->atom = next_atom;
+                next_atom++;
+                send_reply(reply);
+                break;
+            }
+            case X11RequestTypeGetInputFocus:
+            {
+                *(u32*)(reply.data + 7) = window_ids.size != 0 ? window_ids.data[0] : MOCK_X11_ROOT_WINDOW_ID; // focus
+                send_reply(reply);
+                break;
+            }
+            case X11RequestTypeGetProperty:
+            { // only the paste's property ever has a value
+                auto request = (X11GetPropertyRequest*)request_start;
+                if (is_pasting && request->window_id == paste_window_id && request->property == paste_property)
+                {
+                    send_paste_property(request);
+                }
+                else
+                {
+                    send_reply(reply);
+                }
+                break;
+            }
+            case X11RequestTypeDeleteProperty:
+            { // after the INCR reply, this asks for the first chunk
+                auto request = (X11DeletePropertyRequest*)request_start;
+                if (is_pasting && is_paste_incremental && request->window_id == paste_window_id && request->property == paste_property)
+                {
+                    send_property_notify(paste_window_id, paste_property, X11PropertyStateNewValue);
+                }
+                break;
+            }
+            case X11RequestTypeConvertSelection:
+            { // without a paste, nobody owns any selection
+                auto request = (X11ConvertSelectionRequest*)request_start;
+                auto selection_notify = (X11EventSelectionNotify*)&reply;
+                selection_notify->type = X11EventTypeSelectionNotify;
+                selection_notify->time = request->time;
+                selection_notify->requestor_window_id = request->requestor_window_id;
+                selection_notify->selection = request->selection;
+                selection_notify->target = request->target;
+                selection_notify->property = config.paste_size != 0 && !is_pasting ? request->property : X11_ATOM_NONE;
+                if (selection_notify->property != X11_ATOM_NONE)
+                {
+                    is_pasting = true;
+                    is_paste_incremental = false;
+                    paste_window_id = request->requestor_window_id;
+                    paste_property = request->property;
+                    paste_target = request->target;
+                    paste_offset = 0;
+                }
+                send_later(reply);
+                stats.events_sent++;
+                break;
+            }
+            default: break;
+        }
+        return true;
+    }
+
+    // false once the client has hung up
+    bool send_due_messages()
+    {
+        auto now = get_monotonic_time();
+        if (config.expose_interval != 0 && window_ids.size != 0 && now >= next_expose_time)
+        {
+            for (u64 i = 0; i < window_ids.size; i++)
+            {
+                send_expose(window_ids.data[i]);
+            }
+            next_expose_time = now + config.expose_interval;
+        }
+        if (config.key_press_interval != 0 && window_ids.size != 0 && now >= next_key_press_time)
+        {
+            send_next_key_press();
+            next_key_press_time = now + config.key_press_interval;
+        }
+        if (config.paste_size != 0 && !is_paste_pressed && window_ids.size != 0 && now >= start_time + config.paste_delay)
+        {
+            send_key_press(window_ids.data[0], X11KeyCodeV, X11ModifierKeyControl);
+            is_paste_pressed = true;
+        }
+        if (config.resize_interval != 0 && window_ids.size != 0 && now >= next_resize_time)
+        {
+            for (u64 i = 0; i < config.resize_burst_size; i++)
+            {
+                for (u64 window_i = 0; window_i < window_ids.size; window_i++)
+                {
+                    send_configure_notify(window_ids.data[window_i]);
+                }
+            }
+            next_resize_time = now + config.resize_interval;
+        }
+        while (first_outgoing < outgoing.size && outgoing.data[first_outgoing].send_time <= now)
+        {
+            bool is_sent;
+            if (!send_some(&outgoing.data[first_outgoing], &is_sent))
+            {
+                return false;
+            }
+            if (!is_sent)
+            {
+                break;
+            }
+            first_outgoing++;
+        }
+        if (first_outgoing == outgoing.size)
+        {
+            outgoing.clear();
+            first_outgoing = 0;
+        }
+        return true;
+    }
+
+    // serves the one client on the socket until it hangs up
+    void serve()
+    {
+        start_time = get_monotonic_time();
+        if (!handle_handshake())
+        {
+            return;
+        }
+        while (send_due_messages())
+        {
+            PollParameter poll_parameter;
+            poll_parameter.descriptor = socket;
+            poll_parameter.requested_events = PollEventDataAvailable;
+            auto poll_result = poll(&poll_parameter, /* count: */ 1, POLL_TIMEOUT_RETURN_IMMEDIATELY);
+            assert(poll_result >= 0, "MockX11Server: failed to poll the client socket");
+            if (poll_result == 0)
+            {
+                SleepTime sleep_time;
+                sleep_time.seconds = 0;
+                sleep_time.nanoseconds = MOCK_X11_IDLE_SLEEP;
+                nanosleep(&sleep_time);
+                continue;
+            }
+            if (!(poll_parameter.returned_events & PollEventDataAvailable) || !handle_request())
+            {
+                return;
+            }
+        }
+    }
+
+    void print_stats()
+    {
+        auto elapsed_time = max(get_monotonic_time() - start_time, (u64)1);
+        print(
+            "mock server: ", stats.request_count, " requests, ",
+            stats.bytes_received, " bytes received (", stats.bytes_received * 1000 / elapsed_time, " MB/s), ",
+            stats.image_bytes_received, " of them image data, ",
+            stats.bytes_sent, " bytes sent, ",
+            stats.events_sent, " events, ",
+            stats.replies_sent, " replies\n"
+        );
+        for (u64 type = 0; type < 128; type++)
+        {
+            if (stats.request_counts[type] != 0)
+            {
+                print("    request type ", type, ": ", stats.request_counts[type], "\n");
+            }
+        }
+    }
+};
@@ -0,0 +1,150 @@
+// runs the application's frame loop without a display: events come from a script, frames are rendered
+// back to back into memory, and optionally dumped to files; reports the rendering throughput and a checksum
+// of the last frame, so a change in what gets drawn shows up as well
+// ./offscreen.bin [text file to show next to the inputs]
+
+#include <mystd/include_linux.h>
+
+#pragma pack(push, 1)
+
+#include "syscalls.cpp"
+#include "profiler.cpp"
+#include "arena.cpp"
+#include "page_allocator.cpp"
+#include "utf8.cpp"
+#include "codepoint_map.cpp"
+#include "byte_search.cpp"
+#include "x11.cpp"
+#include "x11_trace.cpp"
+#include "x11_connection.cpp"
+#include "renderer.cpp"
+#include "blit.cpp"
+#include "text_renderer.cpp"
+#include "gap_buffer.cpp"
+#include "input_renderer.cpp"
+#include "input_widgets.cpp"
+#include "text_search.cpp"
+#include "document_view.cpp"
+#include "x11_client.cpp"
+#include "app.cpp"
+#include "backend.cpp"
+
+const u64 OFFSCREEN_FRAME_COUNT = 2000;
+const OffscreenDumpFormat OFFSCREEN_DUMP_FORMAT = OffscreenDumpFormatNone;
+
+// FNV-1a, of the visible pixels only
+u64 hash_image(Image image)
+{
+    u64 result = 0xCBF29CE484222325;
+    for (u64 y = 0; y < image.height; y++)
+    {
+        auto bytes = (byte*)(image.data + y * image.stride);
+        for (u64 i = 0; i < image.width * sizeof(Pixel); i++)
+        {
+            result = (result ^ bytes[i]) * 0x100000001B3;
+        }
+    }
+    return result;
+}
+
+// typing, editing and moving around, then enough text to make the input scroll, then clicking and tabbing
+// into the other inputs, then scrolling the document, with keys the inputs ignore
+EventScript create_demo_script()
+{
+    auto script = EventScript::allocate();
+    auto to_string = [](CStringView text)
+    {
+        String result;
+        result.data = (char*)text;
+        result.size = get_c_string_length(text);
+        return result;
+    };
+    u64 frame = 1;
+    frame = script.push_text(frame, to_string("Hello, offscreen world!"), 2);
+    for (u64 i = 0; i < 6; i++, frame += 2)
+    {
+        script.push_key_press(frame, X11KeyCodeBackspace);
+    }
+    script.push_key_press(frame, X11KeyCodeHome);
+    frame = script.push_text(frame + 1, to_string(">> "), 2);
+    script.push_key_press(frame, X11KeyCodeEnd);
+    for (u64 i = 0; i < 20; i++)
+    {
+        frame = script.push_text(frame + 1, to_string(" the quick brown fox jumps over the lazy dog"), 1);
+    }
+    for (u64 i = 0; i < 100; i++, frame += 2)
+    {
+        script.push_key_press(frame, X11KeyCodeLeft);
+    }
+    script.push_button_press(frame, X11ButtonLeft, Vector2<u64>::construct(MAIN_INPUT_X + 10, get_main_input_y(1) + 10));
+    frame = script.push_text(frame + 1, to_string("second"), 2);
+    script.push_key_press(frame, X11KeyCodeTab);
+    frame = script.push_text(frame + 1, to_string("third"), 2);
+    script.push_key_press(frame, X11KeyCodeTab, X11ModifierKeyShift);
+    frame = script.push_text(frame + 1, to_string("s"), 2);
+    auto document_point = Vector2<u64>::construct(DOCUMENT_X + 10, DOCUMENT_Y + 10);
+    script.push_key_press(frame + 1, X11KeyCodePageDown);
+    for (u64 i = 0; i < 3; i++)
+    {
+        script.push_key_press(frame + 2 + i, X11KeyCodeDown);
+    }
+    script.push_button_press(frame + 5, X11ButtonScrollDown, document_point);
+    script.push_button_press(frame + 6, X11ButtonScrollDown, document_point);
+    script.push_button_press(frame + 7, X11ButtonScrollUp, document_point);
+    script.push_key_press(frame + 8, X11KeyCodeUp);
+    return script;
+}
+
+extern "C" void _start()
+{
+    auto script = create_demo_script();
+    auto backend = RenderBackend::construct_offscreen(&script, OFFSCREEN_DUMP_FORMAT);
+    auto image = Image::allocate_in_pages(WINDOW_WIDTH, WINDOW_HEIGHT, SHOULD_LOCK_FRAMEBUFFERS);
+    auto inputs = create_main_inputs();
+    auto document = open_command_line_document();
+    auto events = List<X11Event>::allocate();
+    u64 allocating_frame_count = 0; // of the frames after the script, which should all reuse what earlier ones allocated
+
+    auto start_time = get_monotonic_time();
+    for (u64 i = 0; i < OFFSCREEN_FRAME_COUNT; i++)
+    {
+        auto frame_heap_allocation_count = heap_allocation_count;
+        backend.read_scripted_events(&events);
+        bool is_document_busy = false; // indexing and searching allocate
+        if (document.has_data)
+        {
+            search_document_for_input(&document.value, &inputs);
+            is_document_busy = document.value.update();
+        }
+        render_frame(&inputs, document.has_data ? &document.value : nullptr, events, image);
+        backend.present(image);
+        backend.end_frame();
+        events.clear();
+        allocating_frame_count += script.is_done() && !is_document_busy && heap_allocation_count != frame_heap_allocation_count;
+    }
+    auto elapsed_time = get_monotonic_time() - start_time;
+
+    print(
+        OFFSCREEN_FRAME_COUNT, " frames in ", elapsed_time / 1000, " us, ",
+        elapsed_time / OFFSCREEN_FRAME_COUNT, " ns/frame, ",
+        OFFSCREEN_FRAME_COUNT * 1000 * 1000 * 1000 / elapsed_time, " frames/s\n"
+    );
+    print("framebuffer: ", get_page_mode_name(image.pages.mode), image.pages.is_locked ? ", locked\n" : "\n");
+    print("last frame hash: ", hash_image(image), "\n");
+    print(allocating_frame_count, " frames after the script allocated heap memory\n");
+    if (!script.is_done())
+    {
+        print("warning: the script has events past the last frame\n");
+    }
+
+    events.deallocate();
+    if (document.has_data)
+    {
+        document.value.dispose();
+    }
+    inputs.deallocate();
+    image.deallocate();
+    backend.dispose();
+    script.deallocate();
+    exit(0);
+}
@@ -0,0 +1,93 @@
+// memory for big buffers that are swept every frame, like framebuffers: backed by 2 MB pages where the system
+// allows it, so a full sweep takes a few TLB entries instead of hundreds, and prefaulted, so the first frame
+// doesn't pay for page faults
+
+const u64 SMALL_PAGE_SIZE = 4 * 1024;
+const u64 HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+enum PageMode : u8
+{
+    PageModeHugeTlb, // MAP_HUGETLB, from the pool reserved in /proc/sys/vm/nr_hugepages
+    PageModeTransparentHuge, // MADV_HUGEPAGE, the kernel backs the range with huge pages when it can
+    PageModeSmall, // neither kind of huge page is available
+};
+
+CStringView get_page_mode_name(PageMode mode)
+{
+    switch (mode)
+    {
+        case PageModeHugeTlb: return "hugetlb 2 MB pages";
+        case PageModeTransparentHuge: return "transparent huge pages";
+        case PageModeSmall: return "4 KB pages";
+        default: return "unknown";
+    }
+}
+
+CStringView TRANSPARENT_HUGE_PAGE_SETTING_PATH = "/sys/kernel/mm/transparent_hugepage/enabled";
+
+// madvise succeeds even when transparent huge pages are off, what's in effect is the bracketed word of the
+// setting, e.g. "always [madvise] never"
+bool are_transparent_huge_pages_enabled()
+{
+    auto maybe_file = open_file_read_only(TRANSPARENT_HUGE_PAGE_SETTING_PATH);
+    if (!maybe_file.has_data)
+    {
+        return false;
+    }
+    char setting[64];
+    auto read_size = read(maybe_file.value, setting, sizeof(setting));
+    close(maybe_file.value);
+    for (s64 i = 0; i + 1 < read_size; i++)
+    {
+        if (setting[i] == '[')
+        {
+            return setting[i + 1] == 'a' || setting[i + 1] == 'm'; // always or madvise, not never
+        }
+    }
+    return false;
+}
+
+struct PageAllocation
+{
+    byte* data;
+    u64 size; // rounded up to whole huge pages
+    PageMode mode;
+    bool is_locked;
+
+    // tries hugetlb pages first, then transparent huge pages; `should_lock` also keeps them from being swapped out
+    static PageAllocation allocate(u64 size, bool should_lock = false)
+    {
+        heap_allocation_count++; // not from the heap, but just as much of a cost in a steady-state frame
+        PageAllocation result;
+        result.size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        result.mode = PageModeHugeTlb;
+        result.data = map_memory(result.size, LINUX_PROTECTION_READ | LINUX_PROTECTION_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS | LINUX_MAP_HUGE_TLB);
+        if (result.data == nullptr)
+        { // transparent huge pages only go to huge-page-aligned ranges, so one huge page more is mapped and trimmed
+            auto mapped = map_memory(result.size + HUGE_PAGE_SIZE, LINUX_PROTECTION_READ | LINUX_PROTECTION_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS);
+            assert(mapped != nullptr, "PageAllocation::allocate: failed to map ", size, " bytes");
+            result.data = (byte*)(((u64)mapped + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+            if (result.data != mapped)
+            {
+                unmap_memory(mapped, result.data - mapped);
+            }
+            unmap_memory(result.data + result.size, mapped + HUGE_PAGE_SIZE - result.data);
+            auto is_advised = advise_memory(result.data, result.size, LINUX_MEMORY_ADVICE_HUGE_PAGE);
+            result.mode = is_advised && are_transparent_huge_pages_enabled() ? PageModeTransparentHuge : PageModeSmall;
+        }
+
+        // one write per small page, huge pages get faulted in whole by their first one
+        auto pages = (volatile byte*)result.data;
+        for (u64 offset = 0; offset < result.size; offset += SMALL_PAGE_SIZE)
+        {
+            pages[offset] = 0;
+        }
+        result.is_locked = should_lock && lock_memory(result.data, result.size);
+        return result;
+    }
+
+    void deallocate()
+    {
+        unmap_memory(data, size);
+    }
+};
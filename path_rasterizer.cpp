@@ -0,0 +1,492 @@
+// anti-aliased filling of paths made of lines and quadratic and cubic Béziers, for charts and icons; like the
+// FreeType and font-rs rasterizers, every edge adds its exact area coverage to the pixel cells it crosses,
+// and a running sum along each row turns the cells into coverage; only crossed cells are stored, so the cost
+// goes with the outline's length rather than with the area, and the inside of a shape is filled span by span;
+// there are no floats, coordinates are 24.8 fixed point and the sums are integers, and edges are walked
+// row to row and cell to cell with 16.16 steps, so an edge divides once or twice rather than once per cell
+
+const s64 PATH_ONE = 256; // path coordinates are in 1/256ths of a pixel
+const u64 PATH_ONE_BITS = 8;
+const s64 PATH_FULL_COVERAGE = PATH_ONE * PATH_ONE * 2; // of one pixel, in the units of PathCell::area
+const u64 PATH_TOLERANCE_SQUARED = PATH_ONE; // curves are flattened to within a quarter of a pixel
+const u64 PATH_MAX_CURVE_SEGMENTS = 64;
+
+enum PathFillRule : u8
+{
+    PathFillRuleNonZero,
+    PathFillRuleEvenOdd,
+};
+
+// what the edges crossing one pixel add up to; x is clamped to [-1, width], the cells left of the image
+// only matter for what they add to the running sum, the ones right of it end the row's last span
+struct PathCell
+{
+    s32 x;
+    s32 y;
+    s32 cover; // vertical extent of the edges in the cell, signed by direction, in 1/256ths of a pixel
+    s32 area; // cover times twice the edges' average distance from the cell's left side
+};
+
+// covered part of a pixel in 1/256ths, from a signed coverage in units of PATH_FULL_COVERAGE
+u64 get_path_coverage(s64 value, PathFillRule rule)
+{
+    u64 coverage = (value < 0 ? -value : value) >> (PATH_ONE_BITS + 1);
+    if (rule == PathFillRuleEvenOdd)
+    { // every second winding cancels out
+        coverage &= 511;
+        coverage = coverage > 256 ? 512 - coverage : coverage;
+    }
+    return min(coverage, (u64)256);
+}
+
+// `color` at `coverage` out of 256 over the pixels from `start_x` up to `end_x` of `row`, which are inside the
+// image; the color's half of blend_pixel is done once for the whole span
+void blend_path_span(Pixel* row, s64 start_x, s64 end_x, Pixel color, u64 coverage)
+{
+    if (coverage == 256)
+    {
+        fill_pixels(row + start_x, end_x - start_x, color);
+        return;
+    }
+    u32 alpha = coverage - (coverage >> 8);
+    auto inverse_alpha = 0xFF - alpha;
+    u32 color_red_blue = (color & 0x00FF00FF) * alpha;
+    u32 color_alpha_green = (((color >> 8) & 0x00FF00FF) | 0x00FF0000) * alpha;
+    for (auto x = start_x; x < end_x; x++)
+    {
+        auto destination = row[x];
+        u32 red_blue = color_red_blue + (destination & 0x00FF00FF) * inverse_alpha;
+        u32 alpha_green = color_alpha_green + ((destination >> 8) & 0x00FF00FF) * inverse_alpha;
+        red_blue = ((red_blue + 0x00010001 + ((red_blue >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        alpha_green = ((alpha_green + 0x00010001 + ((alpha_green >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        row[x] = red_blue | (alpha_green << 8);
+    }
+}
+
+// a row's cells, added up per x and in x order, give the coverage of their own pixel and of the span before each
+// of them: a running sum of their cover, with the cell's area taken off its own pixel
+void resolve_path_row_scalar(s32* covers, s32* areas, u64 count, PathFillRule rule, u32* cell_coverages, u32* span_coverages)
+{
+    s64 cover = 0;
+    for (u64 i = 0; i < count; i++)
+    {
+        span_coverages[i] = get_path_coverage(cover * PATH_ONE * 2, rule);
+        cover += covers[i];
+        cell_coverages[i] = get_path_coverage(cover * PATH_ONE * 2 - areas[i], rule);
+    }
+}
+
+typedef s32 __attribute__((vector_size(32))) Avx2Ints;
+typedef s32 __attribute__((vector_size(32), may_alias, aligned(4))) UnalignedAvx2Ints;
+
+// get_path_coverage for 8 values at once
+__attribute__((target("avx2")))
+Avx2Ints get_path_coverages_avx2(Avx2Ints values, PathFillRule rule)
+{
+    auto coverages = __builtin_ia32_pabsd256(values) >> (PATH_ONE_BITS + 1);
+    if (rule == PathFillRuleEvenOdd)
+    {
+        coverages &= 511;
+        return __builtin_ia32_pminsd256(coverages, 512 - coverages);
+    }
+    Avx2Ints full = {256, 256, 256, 256, 256, 256, 256, 256};
+    return __builtin_ia32_pminsd256(coverages, full);
+}
+
+// resolve_path_row_scalar 8 cells at a time, `count` is a multiple of 8 and the covers past the row's cells are
+// zero; the running sum is a prefix sum within each 128-bit half, the lower half's total is added to the upper
+// half, and the total of the cells before to both; it's 32 bits wide like the slots, which is plenty for
+// thousands of overlapping windings
+__attribute__((target("avx2")))
+void resolve_path_row_avx2(s32* covers, s32* areas, u64 count, PathFillRule rule, u32* cell_coverages, u32* span_coverages)
+{
+    Avx2Ints upper_half = {0, 0, 0, 0, -1, -1, -1, -1};
+    Avx2Ints lower_half_last = {3, 3, 3, 3, 3, 3, 3, 3};
+    Avx2Ints last = {7, 7, 7, 7, 7, 7, 7, 7};
+    Avx2Ints total = {};
+    for (u64 i = 0; i < count; i += 8)
+    {
+        Avx2Ints cell_covers = *(UnalignedAvx2Ints*)(covers + i);
+        auto sums = cell_covers + (Avx2Ints)__builtin_ia32_pslldqi256((Avx2Quadwords)cell_covers, 4 * 8);
+        sums += (Avx2Ints)__builtin_ia32_pslldqi256((Avx2Quadwords)sums, 8 * 8);
+        sums += __builtin_ia32_permvarsi256(sums, lower_half_last) & upper_half;
+        sums += total;
+        total = __builtin_ia32_permvarsi256(sums, last);
+        Avx2Ints cell_areas = *(UnalignedAvx2Ints*)(areas + i);
+        *(UnalignedAvx2Ints*)(span_coverages + i) = get_path_coverages_avx2((sums - cell_covers) * (s32)(PATH_ONE * 2), rule);
+        *(UnalignedAvx2Ints*)(cell_coverages + i) = get_path_coverages_avx2(sums * (s32)(PATH_ONE * 2) - cell_areas, rule);
+    }
+}
+
+// reused from path to path, the cells only grow until the biggest path fits; per path:
+// begin, move_to/line_to/quadratic_to/cubic_to/close or stroke_line, then fill
+struct PathRasterizer
+{
+    List<PathCell> cells;
+    ImageView image;
+    Vector2<s64> contour_start;
+    Vector2<s64> current;
+    s64 top_row; // the rows the cells are in, so that sorting them doesn't look at the whole image's height
+    s64 bottom_row;
+
+    static PathRasterizer allocate()
+    {
+        PathRasterizer result;
+        result.cells = List<PathCell>::allocate();
+        result.contour_start = Vector2<s64>::construct(0, 0);
+        result.current = result.contour_start;
+        result.top_row = 0;
+        result.bottom_row = -1;
+        return result;
+    }
+
+    void deallocate()
+    {
+        cells.deallocate();
+    }
+
+    void begin(ImageView target)
+    {
+        image = target;
+        cells.clear();
+        contour_start = Vector2<s64>::construct(0, 0);
+        current = contour_start;
+        top_row = image.height;
+        bottom_row = -1;
+    }
+
+    void add_cell(s64 x, s64 y, s64 cover, s64 area)
+    {
+        // cells in the same place aren't merged here, fill adds them up anyway
+        PathCell cell;
+        x = min(max(x, (s64)-1), (s64)image.width);
+        cell.x = x;
+        cell.y = y;
+        cell.cover = cover;
+        cell.area = area;
+        cells.push(cell);
+    }
+
+    // a piece of an edge that stays within row `y`, the y coordinates are from the row's top; `y_per_x` is how far
+    // the edge goes in y per unit of x, unsigned and in 16.16 fixed point, so crossing into the next cell is
+    // an addition; what the rounding leaves over goes to the piece's last cell, so the cover always adds up
+    void add_row_edge(s64 y, s64 start_x, s64 start_y, s64 end_x, s64 end_y, s64 y_per_x)
+    {
+        if (max(start_x, end_x) < 0)
+        {
+            add_cell(-1, y, end_y - start_y, 0);
+            return;
+        }
+        if (min(start_x, end_x) >= (s64)image.width * PATH_ONE)
+        {
+            add_cell(image.width, y, end_y - start_y, 0);
+            return;
+        }
+        auto start_cell = start_x >> PATH_ONE_BITS;
+        auto end_cell = end_x >> PATH_ONE_BITS;
+        auto cell = start_cell;
+        auto x = start_x;
+        auto cell_y = start_y;
+        if (cell != end_cell)
+        {
+            auto step = end_x > start_x ? 1 : -1;
+            auto first_width = step > 0 ? (cell + 1) * PATH_ONE - start_x : start_x - cell * PATH_ONE;
+            auto lowest_y = min(start_y, end_y) << 16;
+            auto highest_y = max(start_y, end_y) << 16;
+            auto y_step = end_y > start_y ? y_per_x : -y_per_x;
+            auto boundary_y_fixed = (start_y << 16) + first_width * y_step;
+            while (cell != end_cell)
+            { // up to where the edge leaves the cell
+                auto boundary_x = (step > 0 ? cell + 1 : cell) * PATH_ONE;
+                boundary_y_fixed = min(max(boundary_y_fixed, lowest_y), highest_y);
+                auto boundary_y = boundary_y_fixed >> 16;
+                auto cell_left = cell * PATH_ONE;
+                add_cell(cell, y, boundary_y - cell_y, (boundary_y - cell_y) * (x - cell_left + boundary_x - cell_left));
+                x = boundary_x;
+                cell_y = boundary_y;
+                cell += step;
+                boundary_y_fixed += y_step * PATH_ONE;
+            }
+        }
+        auto cell_left = end_cell * PATH_ONE;
+        add_cell(end_cell, y, end_y - cell_y, (end_y - cell_y) * (x - cell_left + end_x - cell_left));
+    }
+
+    void add_edge(Vector2<s64> start, Vector2<s64> end)
+    {
+        if (start.y == end.y)
+        { // horizontal edges don't cover anything
+            return;
+        }
+        // rows from the top, whichever way the edge goes; where a piece ends in x is where the next one starts
+        auto is_downward = end.y > start.y;
+        auto top = is_downward ? start : end;
+        auto bottom = is_downward ? end : start;
+        auto first_row = max(top.y >> PATH_ONE_BITS, (s64)0);
+        auto last_row = min((bottom.y - 1) >> PATH_ONE_BITS, (s64)image.height - 1);
+        if (first_row > last_row)
+        {
+            return;
+        }
+        top_row = min(top_row, first_row);
+        bottom_row = max(bottom_row, last_row);
+
+        // x where the edge crosses the row boundaries, in 16.16 fixed point so that a row further down is an
+        // addition; it's off by at most a 256th of a pixel per 256 rows, and the last piece ends exactly at `bottom`
+        auto delta_x = bottom.x - top.x;
+        auto delta_y = bottom.y - top.y;
+        auto x_per_y = delta_x * 65536 / delta_y;
+        auto piece_top = max(top.y, first_row * PATH_ONE);
+        auto piece_top_x = top.x + ((piece_top - top.y) * x_per_y >> 16);
+        auto boundary_x_fixed = top.x * 65536 + ((first_row + 1) * PATH_ONE - top.y) * x_per_y;
+        // only needed when the edge crosses from one column of cells into another
+        auto is_within_column = (top.x >> PATH_ONE_BITS) == (bottom.x >> PATH_ONE_BITS);
+        auto y_per_x = is_within_column ? 0 : delta_y * 65536 / (delta_x < 0 ? -delta_x : delta_x);
+        for (auto row = first_row; row <= last_row; row++)
+        {
+            auto row_top = row * PATH_ONE;
+            auto piece_bottom = min(bottom.y, row_top + PATH_ONE);
+            auto piece_bottom_x = piece_bottom == bottom.y ? bottom.x : boundary_x_fixed >> 16;
+            if (is_downward)
+            {
+                add_row_edge(row, piece_top_x, piece_top - row_top, piece_bottom_x, piece_bottom - row_top, y_per_x);
+            }
+            else
+            {
+                add_row_edge(row, piece_bottom_x, piece_bottom - row_top, piece_top_x, piece_top - row_top, y_per_x);
+            }
+            piece_top = piece_bottom;
+            piece_top_x = piece_bottom_x;
+            boundary_x_fixed += PATH_ONE * x_per_y;
+        }
+    }
+
+    // starts a new contour, the previous one gets closed
+    void move_to(Vector2<s64> point)
+    {
+        close();
+        contour_start = point;
+        current = point;
+    }
+
+    void line_to(Vector2<s64> point)
+    {
+        add_edge(current, point);
+        current = point;
+    }
+
+    void quadratic_to(Vector2<s64> control, Vector2<s64> end)
+    {
+        // the curve is at most a quarter of this far from its chord; n segments divide that by n^2
+        auto deviation_x = current.x - control.x * 2 + end.x;
+        auto deviation_y = current.y - control.y * 2 + end.y;
+        u64 deviation = max(deviation_x < 0 ? -deviation_x : deviation_x, deviation_y < 0 ? -deviation_y : deviation_y);
+        s64 segment_count = min(1 + get_integer_square_root(deviation / PATH_TOLERANCE_SQUARED), PATH_MAX_CURVE_SEGMENTS);
+        auto start = current;
+        auto divisor = segment_count * segment_count;
+        for (s64 i = 1; i <= segment_count; i++)
+        {
+            auto rest = segment_count - i;
+            line_to(Vector2<s64>::construct(
+                (rest * rest * start.x + 2 * i * rest * control.x + i * i * end.x) / divisor,
+                (rest * rest * start.y + 2 * i * rest * control.y + i * i * end.y) / divisor
+            ));
+        }
+    }
+
+    void cubic_to(Vector2<s64> first_control, Vector2<s64> second_control, Vector2<s64> end)
+    {
+        s64 deviations[] = {
+            current.x - first_control.x * 2 + second_control.x,
+            current.y - first_control.y * 2 + second_control.y,
+            first_control.x - second_control.x * 2 + end.x,
+            first_control.y - second_control.y * 2 + end.y,
+        };
+        u64 deviation = 0;
+        for (auto value : deviations)
+        {
+            deviation = max(deviation, (u64)(value < 0 ? -value : value));
+        }
+        s64 segment_count = min(1 + get_integer_square_root(deviation * 3 / PATH_TOLERANCE_SQUARED), PATH_MAX_CURVE_SEGMENTS);
+        auto start = current;
+        auto divisor = segment_count * segment_count * segment_count;
+        for (s64 i = 1; i <= segment_count; i++)
+        {
+            auto rest = segment_count - i;
+            auto start_weight = rest * rest * rest;
+            auto first_weight = 3 * i * rest * rest;
+            auto second_weight = 3 * i * i * rest;
+            auto end_weight = i * i * i;
+            line_to(Vector2<s64>::construct(
+                (start_weight * start.x + first_weight * first_control.x + second_weight * second_control.x + end_weight * end.x) / divisor,
+                (start_weight * start.y + first_weight * first_control.y + second_weight * second_control.y + end_weight * end.y) / divisor
+            ));
+        }
+    }
+
+    void close()
+    {
+        line_to(contour_start);
+    }
+
+    // a contour of its own, `width` wide and with square ends, so the segments of a polyline overlap at the joints;
+    // every such contour winds the same way, so they add up to one shape under PathFillRuleNonZero
+    void stroke_line(Vector2<s64> start, Vector2<s64> end, s64 width)
+    {
+        auto delta_x = end.x - start.x;
+        auto delta_y = end.y - start.y;
+        if (delta_x == 0 && delta_y == 0)
+        {
+            delta_x = 1;
+        }
+        s64 length = get_integer_square_root(delta_x * delta_x + delta_y * delta_y);
+        length = max(length, (s64)1);
+        auto half_width_per_length = width * 32768 / length; // 16.16
+        auto along_x = delta_x * half_width_per_length >> 16;
+        auto along_y = delta_y * half_width_per_length >> 16;
+        // to the left of the direction, then the ends pushed out
+        auto offset_x = -along_y;
+        auto offset_y = along_x;
+        auto from = Vector2<s64>::construct(start.x - along_x, start.y - along_y);
+        auto to = Vector2<s64>::construct(end.x + along_x, end.y + along_y);
+        move_to(Vector2<s64>::construct(from.x + offset_x, from.y + offset_y));
+        line_to(Vector2<s64>::construct(to.x + offset_x, to.y + offset_y));
+        line_to(Vector2<s64>::construct(to.x - offset_x, to.y - offset_y));
+        line_to(Vector2<s64>::construct(from.x - offset_x, from.y - offset_y));
+        close();
+    }
+
+    // groups the cells by row, and sweeps each row with a running sum of their cover; between two cells, a row's
+    // coverage is that sum alone, so it's drawn as one span; the cells of a row are first added up per x, and bits
+    // set per x give them back in x order, so nothing has to be sorted by x, then the sum is taken over just the
+    // row's cells, 8 at a time with AVX2
+    void fill(Pixel color, PathFillRule rule, Arena* scratch)
+    {
+        auto zone = profile_begin("PathRasterizer::fill");
+        close();
+        u64* row_ends;
+        auto sorted = sort_cells_by_row(scratch, &row_ends);
+        auto slot_count = image.width + 2; // x from -1 to width
+        auto word_count = (slot_count + 63) / 64;
+        auto slot_covers = scratch->push_array<s32>(slot_count);
+        auto slot_areas = scratch->push_array<s32>(slot_count);
+        auto touched = scratch->push_array<u64>(word_count);
+        for (u64 slot = 0; slot < slot_count; slot++)
+        {
+            slot_covers[slot] = 0;
+            slot_areas[slot] = 0;
+        }
+        for (u64 word_i = 0; word_i < word_count; word_i++)
+        {
+            touched[word_i] = 0;
+        }
+        // the current row's cells in x order, with room to round their count up to a multiple of 8
+        auto row_capacity = slot_count + 7;
+        auto row_slots = scratch->push_array<u32>(row_capacity);
+        auto row_covers = scratch->push_array<s32>(row_capacity);
+        auto row_areas = scratch->push_array<s32>(row_capacity);
+        auto cell_coverages = scratch->push_array<u32>(row_capacity);
+        auto span_coverages = scratch->push_array<u32>(row_capacity); // of the span right before the cell
+        auto is_avx2 = is_avx2_available();
+
+        u64 i = 0;
+        for (auto y = top_row; y <= bottom_row; y++)
+        {
+            auto row_end = row_ends[y - top_row];
+            if (i == row_end)
+            {
+                continue;
+            }
+            auto first_slot = slot_count;
+            u64 last_slot = 0;
+            for (; i < row_end; i++)
+            {
+                u64 slot = sorted[i].x + 1;
+                slot_covers[slot] += sorted[i].cover;
+                slot_areas[slot] += sorted[i].area;
+                touched[slot / 64] |= (u64)1 << (slot % 64);
+                first_slot = min(first_slot, slot);
+                last_slot = max(last_slot, slot);
+            }
+
+            u64 row_cell_count = 0;
+            for (auto word_i = first_slot / 64; word_i <= last_slot / 64; word_i++)
+            {
+                auto bits = touched[word_i];
+                touched[word_i] = 0;
+                while (bits != 0)
+                {
+                    auto slot = word_i * 64 + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    row_slots[row_cell_count] = slot;
+                    row_covers[row_cell_count] = slot_covers[slot];
+                    row_areas[row_cell_count] = slot_areas[slot];
+                    slot_covers[slot] = 0;
+                    slot_areas[slot] = 0;
+                    row_cell_count++;
+                }
+            }
+            if (is_avx2)
+            {
+                auto rounded_count = (row_cell_count + 7) & ~(u64)7;
+                for (auto cell_i = row_cell_count; cell_i < rounded_count; cell_i++)
+                {
+                    row_covers[cell_i] = 0;
+                    row_areas[cell_i] = 0;
+                }
+                resolve_path_row_avx2(row_covers, row_areas, rounded_count, rule, cell_coverages, span_coverages);
+            }
+            else
+            {
+                resolve_path_row_scalar(row_covers, row_areas, row_cell_count, rule, cell_coverages, span_coverages);
+            }
+
+            auto row = image.get_row(y);
+            s64 x = 0; // where the span before the next cell starts
+            for (u64 cell_i = 0; cell_i < row_cell_count; cell_i++)
+            {
+                s64 cell_x = (s64)row_slots[cell_i] - 1;
+                if (cell_x > x && span_coverages[cell_i] != 0)
+                {
+                    blend_path_span(row, x, cell_x, color, span_coverages[cell_i]);
+                }
+                if (cell_x >= 0 && cell_x < (s64)image.width && cell_coverages[cell_i] != 0)
+                {
+                    blend_path_span(row, cell_x, cell_x + 1, color, cell_coverages[cell_i]);
+                }
+                x = cell_x + 1;
+            }
+        }
+        cells.clear();
+        profile_end(zone);
+    }
+
+    // a counting sort over the rows the cells are in; `row_ends` gets where each row's cells end
+    PathCell* sort_cells_by_row(Arena* scratch, u64** row_ends_result)
+    {
+        auto row_count = top_row <= bottom_row ? bottom_row - top_row + 1 : 0;
+        auto row_ends = scratch->push_array<u64>(row_count);
+        auto sorted = scratch->push_array<PathCell>(cells.size);
+        for (s64 row = 0; row < row_count; row++)
+        {
+            row_ends[row] = 0;
+        }
+        for (u64 i = 0; i < cells.size; i++)
+        {
+            row_ends[cells.data[i].y - top_row]++;
+        }
+        u64 offset = 0;
+        for (s64 row = 0; row < row_count; row++)
+        { // where the row starts for now, then where it ends once its cells are in
+            auto count = row_ends[row];
+            row_ends[row] = offset;
+            offset += count;
+        }
+        for (u64 i = 0; i < cells.size; i++)
+        {
+            sorted[row_ends[cells.data[i].y - top_row]++] = cells.data[i];
+        }
+        *row_ends_result = row_ends;
+        return sorted;
+    }
+};
@@ -0,0 +1,189 @@
+// scoped timing zones based on the time stamp counter, exported as Chrome trace-event JSON
+// (chrome://tracing or ui.perfetto.dev); when disabled, a zone costs one predictable branch on each end
+
+const u64 PROFILER_RECORD_COUNT = 64 * 1024; // the oldest records get overwritten
+const u64 PROFILER_CALIBRATION_TIME = 10 * 1000 * 1000; // in nanoseconds
+
+u64 read_time_stamp_counter()
+{
+    u32 low;
+    u32 high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((u64)high << 32) | low;
+}
+
+// the counter runs at a constant rate on anything recent, it's measured against the monotonic clock once;
+// returns 32.32 fixed point
+u64 measure_nanoseconds_per_tick()
+{
+    auto start_time = get_monotonic_time();
+    auto start_ticks = read_time_stamp_counter();
+    while (get_monotonic_time() - start_time < PROFILER_CALIBRATION_TIME)
+    {
+    }
+    auto elapsed_time = get_monotonic_time() - start_time;
+    auto elapsed_ticks = read_time_stamp_counter() - start_ticks;
+    return (elapsed_time << 32) / elapsed_ticks;
+}
+
+u64 measured_nanoseconds_per_tick; // 0 until the first get_nanoseconds_per_tick
+
+// measured once, the first call takes PROFILER_CALIBRATION_TIME; the application makes that call at startup, so
+// switching profiling or tracing on later doesn't stall a frame
+u64 get_nanoseconds_per_tick()
+{
+    if (measured_nanoseconds_per_tick == 0)
+    {
+        measured_nanoseconds_per_tick = measure_nanoseconds_per_tick();
+    }
+    return measured_nanoseconds_per_tick;
+}
+
+u64 convert_ticks_to_nanoseconds(u64 ticks, u64 nanoseconds_per_tick)
+{
+    return (u64)(((unsigned __int128)ticks * nanoseconds_per_tick) >> 32);
+}
+
+struct ProfilerRecord
+{
+    CStringView name;
+    u64 start_ticks;
+    u64 end_ticks;
+};
+
+// one per thread, records are only ever written by the thread that owns the profiler
+struct Profiler
+{
+    bool is_enabled;
+    ProfilerRecord* records; // ring buffer, allocated when first enabled
+    u64 record_count; // ever written, the ring index is record_count % PROFILER_RECORD_COUNT
+    u64 base_ticks;
+    u64 nanoseconds_per_tick; // 32.32 fixed point
+
+    void enable()
+    {
+        if (records == nullptr)
+        {
+            records = (ProfilerRecord*)map_memory(
+                PROFILER_RECORD_COUNT * sizeof(ProfilerRecord),
+                LINUX_PROTECTION_READ | LINUX_PROTECTION_WRITE,
+                LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS
+            );
+            assert(records != nullptr, "Profiler::enable: failed to allocate the record buffer");
+            nanoseconds_per_tick = get_nanoseconds_per_tick();
+            base_ticks = read_time_stamp_counter();
+        }
+        is_enabled = true;
+    }
+
+    void disable()
+    {
+        is_enabled = false;
+    }
+
+    u64 ticks_to_nanoseconds(u64 ticks)
+    {
+        return convert_ticks_to_nanoseconds(ticks, nanoseconds_per_tick);
+    }
+
+    void export_chrome_trace(CStringView path)
+    {
+        auto maybe_file = open_file_for_writing(path);
+        if (!maybe_file.has_data)
+        {
+            print("Failed to open ", path, " for writing\n");
+            return;
+        }
+
+        auto json = String::allocate();
+        push_text(&json, "{\"traceEvents\":[\n");
+        auto first = record_count > PROFILER_RECORD_COUNT ? record_count - PROFILER_RECORD_COUNT : 0;
+        for (auto i = first; i < record_count; i++)
+        {
+            auto record = records[i % PROFILER_RECORD_COUNT];
+            push_text(&json, "{\"name\":\"");
+            push_text(&json, record.name);
+            push_text(&json, "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":");
+            push_microseconds(&json, ticks_to_nanoseconds(record.start_ticks - base_ticks));
+            push_text(&json, ",\"dur\":");
+            push_microseconds(&json, ticks_to_nanoseconds(record.end_ticks - record.start_ticks));
+            push_text(&json, i + 1 < record_count ? "},\n" : "}\n");
+        }
+        push_text(&json, "]}\n");
+
+        auto write_result = write(maybe_file.value, json.data, json.size);
+        if (write_result != (s64)json.size)
+        {
+            print("Failed to write ", path, "\n");
+        }
+        close(maybe_file.value);
+        json.deallocate();
+        print("Wrote ", record_count - first, " profiler records to ", path, "\n");
+    }
+
+    static void push_text(String* string, CStringView text)
+    {
+        for (u64 i = 0; text[i] != 0; i++)
+        {
+            string->push(text[i]);
+        }
+    }
+
+    // microseconds with three decimals, which is what the trace format expects
+    static void push_microseconds(String* string, u64 nanoseconds)
+    {
+        char digits[24];
+        u64 digit_count = 0;
+        auto value = nanoseconds;
+        do
+        {
+            digits[digit_count] = '0' + value % 10;
+            digit_count++;
+            value /= 10;
+        }
+        while (value != 0 || digit_count < 4);
+        for (auto i = digit_count; i > 0; i--)
+        {
+            if (i == 3)
+            {
+                string->push('.');
+            }
+            string->push(digits[i - 1]);
+        }
+    }
+};
+
+// threads other than the main one would need their own
+Profiler main_thread_profiler; // zeroed, so disabled
+
+struct ProfileZone
+{
+    CStringView name;
+    u64 start_ticks; // 0 if the profiler was disabled when the zone began
+};
+
+// ends are matched with begins by hand, zones nest the way the calls do
+ProfileZone profile_begin(CStringView name)
+{
+    ProfileZone result;
+    result.name = name;
+    result.start_ticks = 0;
+    if (__builtin_expect(main_thread_profiler.is_enabled, false))
+    {
+        result.start_ticks = read_time_stamp_counter();
+    }
+    return result;
+}
+
+void profile_end(ProfileZone zone)
+{
+    if (__builtin_expect(zone.start_ticks != 0, false))
+    {
+        auto profiler = &main_thread_profiler;
+        auto record = &profiler->records[profiler->record_count % PROFILER_RECORD_COUNT];
+        record->name = zone.name;
+        record->start_ticks = zone.start_ticks;
+        record->end_ticks = read_time_stamp_counter();
+        profiler->record_count++;
+    }
+}
@@ -3,34 +3,455 @@ typedef u32 Pixel;
 const Pixel BLACK = 0;
 const Pixel WHITE = -1;
 
+const u64 IMAGE_ROW_ALIGNMENT = 64; // in bytes, rows start on a cache line
+const u64 IMAGE_ROW_ALIGNMENT_IN_PIXELS = IMAGE_ROW_ALIGNMENT / sizeof(Pixel);
+
+// SSE isn't available in this build, so a u64 is our vector: two pixels at a time here and in the blits, and
+// eight bytes at a time in byte_search
+typedef u64 __attribute__((may_alias)) PixelPair;
+
+// the fill kernel that every primitive below ends up in, all of them draw horizontal spans
+void fill_pixels(Pixel* data, u64 count, Pixel color)
+{
+    u64 i = 0;
+    if (count != 0 && (u64)data % sizeof(PixelPair) != 0)
+    {
+        data[0] = color;
+        i = 1;
+    }
+    auto pair = (u64)color << 32 | color;
+    for (; i + 2 <= count; i += 2)
+    {
+        *(PixelPair*)(data + i) = pair;
+    }
+    if (i < count)
+    {
+        data[i] = color;
+    }
+}
+
+struct Rectangle
+{
+    Vector2<u64> position;
+    Vector2<u64> dimensions;
+
+    static Rectangle construct(Vector2<u64> position, Vector2<u64> dimensions)
+    {
+        Rectangle result;
+        result.position = position;
+        result.dimensions = dimensions;
+        return result;
+    }
+};
+
+// a rectangle of an image's pixels, rows are `stride` pixels apart; views don't own their pixels, so they're
+// cheap to make for any part of an image, and whatever renders into a view works in its local coordinates
+struct ImageView
+{
+    Pixel* data;
+    u64 width;
+    u64 height;
+    u64 stride; // in pixels
+
+    Pixel* get_row(u64 y)
+    {
+        return data + y * stride;
+    }
+
+    // clipped to this view, so it can come out smaller than asked for, or empty
+    ImageView get_sub_view(Vector2<u64> position, Vector2<u64> dimensions)
+    {
+        ImageView result;
+        auto x = min(position.x, width);
+        auto y = min(position.y, height);
+        result.data = data + y * stride + x;
+        result.width = min(dimensions.x, width - x);
+        result.height = min(dimensions.y, height - y);
+        result.stride = stride;
+        return result;
+    }
+
+    void clear(Pixel color)
+    {
+        for (u64 y = 0; y < height; y++)
+        {
+            fill_pixels(get_row(y), width, color);
+        }
+    }
+};
+
+// owns its pixels; rows are padded to IMAGE_ROW_ALIGNMENT, the padding is never drawn into
 struct Image
 {
     Pixel* data;
     u64 width;
     u64 height;
+    u64 stride; // in pixels
+    u64 capacity; // in pixels
+    byte* allocation; // from the heap, nullptr when the pixels are in an arena or in pages
+    bool is_in_pages;
+    bool should_lock_pages;
+    PageAllocation pages;
+
+    static u64 get_stride(u64 width)
+    {
+        return (width + IMAGE_ROW_ALIGNMENT_IN_PIXELS - 1) / IMAGE_ROW_ALIGNMENT_IN_PIXELS * IMAGE_ROW_ALIGNMENT_IN_PIXELS;
+    }
 
     static Image allocate(u64 width, u64 height)
     {
         Image result;
         result.width = width;
         result.height = height;
-        result.data = (Pixel*)default_allocate(width * height * sizeof(Pixel));
+        result.stride = get_stride(width);
+        result.capacity = result.stride * height;
+        result.is_in_pages = false;
+        result.allocate_pixels();
+        return result;
+    }
+
+    // for framebuffers and other images that are swept every frame, see PageAllocation;
+    // pages.mode tells which kind of pages it got
+    static Image allocate_in_pages(u64 width, u64 height, bool should_lock = false)
+    {
+        Image result;
+        result.width = width;
+        result.height = height;
+        result.stride = get_stride(width);
+        result.capacity = result.stride * height;
+        result.is_in_pages = true;
+        result.should_lock_pages = should_lock;
+        result.allocate_pixels();
         return result;
     }
 
+    // lives until `arena` is reset, mustn't be deallocated or resized
+    static Image allocate_in(Arena* arena, u64 width, u64 height)
+    {
+        Image result;
+        result.width = width;
+        result.height = height;
+        result.stride = get_stride(width);
+        result.capacity = result.stride * height;
+        result.data = arena->push_array<Pixel>(result.capacity, IMAGE_ROW_ALIGNMENT);
+        result.allocation = nullptr;
+        result.is_in_pages = false;
+        return result;
+    }
+
+    void allocate_pixels()
+    {
+        if (is_in_pages)
+        { // whatever the rounding up to whole pages added is capacity as well
+            pages = PageAllocation::allocate(capacity * sizeof(Pixel), should_lock_pages);
+            data = (Pixel*)pages.data;
+            capacity = pages.size / sizeof(Pixel);
+            allocation = nullptr;
+            return;
+        }
+        allocation = heap_allocate(capacity * sizeof(Pixel) + IMAGE_ROW_ALIGNMENT);
+        data = (Pixel*)(((u64)allocation + IMAGE_ROW_ALIGNMENT - 1) & ~(IMAGE_ROW_ALIGNMENT - 1));
+    }
+
+    void deallocate_pixels()
+    {
+        if (is_in_pages)
+        {
+            pages.deallocate();
+        }
+        else
+        {
+            default_deallocate(allocation);
+        }
+    }
+
+    // grow-only, so a window being resized back and forth settles on one allocation; the pixels are lost
+    void resize(u64 new_width, u64 new_height)
+    {
+        auto new_stride = get_stride(new_width);
+        if (new_stride * new_height > capacity)
+        {
+            deallocate_pixels();
+            capacity = max(new_stride * new_height, capacity + capacity / 2);
+            allocate_pixels();
+        }
+        width = new_width;
+        height = new_height;
+        stride = new_stride;
+    }
+
     void deallocate()
     {
-        default_deallocate(data);
+        deallocate_pixels();
+    }
+
+    ImageView get_view()
+    {
+        ImageView result;
+        result.data = data;
+        result.width = width;
+        result.height = height;
+        result.stride = stride;
+        return result;
+    }
+
+    operator ImageView()
+    {
+        return get_view();
     }
 
     void clear(Pixel color)
     {
-        for (u64 y = 0; y < height; y++)
+        auto zone = profile_begin("Image::clear");
+        get_view().clear(color);
+        profile_end(zone);
+    }
+};
+
+// pixels from `start_x` up to `end_x` of row `y`, clipped to the view; the coordinates are signed, so that
+// primitives going past the top or the left edge can hand their spans over as they are
+void render_span(ImageView image, s64 y, s64 start_x, s64 end_x, Pixel color)
+{
+    if (y < 0 || y >= (s64)image.height)
+    {
+        return;
+    }
+    start_x = max(start_x, (s64)0);
+    end_x = min(end_x, (s64)image.width);
+    if (start_x < end_x)
+    {
+        fill_pixels(image.get_row(y) + start_x, end_x - start_x, color);
+    }
+}
+
+void render_filled_box(ImageView image, Vector2<u64> position, Vector2<u64> dimensions, Pixel color)
+{
+    auto zone = profile_begin("render_filled_box");
+    image.get_sub_view(position, dimensions).clear(color);
+    profile_end(zone);
+}
+
+// Bresenham, both ends included; the pixels of a line that share a row go out as one span
+void render_line(ImageView image, Vector2<u64> start, Vector2<u64> end, Pixel color)
+{
+    auto zone = profile_begin("render_line");
+    s64 x = start.x;
+    s64 y = start.y;
+    s64 end_x = end.x;
+    s64 end_y = end.y;
+    s64 delta_x = end_x > x ? end_x - x : x - end_x;
+    s64 delta_y = end_y > y ? y - end_y : end_y - y; // negative
+    s64 step_x = end_x > x ? 1 : -1;
+    s64 step_y = end_y > y ? 1 : -1;
+    auto error = delta_x + delta_y;
+    auto run_start_x = x;
+    while (x != end_x || y != end_y)
+    {
+        auto next_x = x;
+        auto next_y = y;
+        auto doubled_error = error * 2;
+        if (doubled_error >= delta_y)
+        {
+            error += delta_y;
+            next_x += step_x;
+        }
+        if (doubled_error <= delta_x)
+        {
+            error += delta_x;
+            next_y += step_y;
+        }
+        if (next_y != y)
+        {
+            render_span(image, y, min(run_start_x, x), max(run_start_x, x) + 1, color);
+            run_start_x = next_x;
+        }
+        x = next_x;
+        y = next_y;
+    }
+    render_span(image, y, min(run_start_x, x), max(run_start_x, x) + 1, color);
+    profile_end(zone);
+}
+
+u64 get_integer_square_root(u64 value)
+{
+    // one bit of the result per iteration, from the highest one it can have
+    if (value == 0)
+    {
+        return 0;
+    }
+    u64 result = 0;
+    u64 bit = (u64)1 << ((63 - __builtin_clzll(value)) & ~1);
+    while (bit != 0)
+    { // without a branch, whether a bit is set is as good as random
+        auto candidate = result + bit;
+        auto is_set_mask = -(u64)(value >= candidate);
+        value -= candidate & is_set_mask;
+        result = (result >> 1) + (bit & is_set_mask);
+        bit >>= 2;
+    }
+    return result;
+}
+
+const s64 RENDERER_FIXED_ONE = 1 << 16; // coordinates of polygons are 16.16 fixed point
+const s64 RENDERER_FIXED_HALF = RENDERER_FIXED_ONE / 2;
+
+// a pixel is inside if its center is; every row is a single span, so the polygon has to be convex
+void render_convex_polygon(ImageView image, Vector2<s64>* vertices, u64 vertex_count, Pixel color)
+{
+    auto top = vertices[0].y;
+    auto bottom = vertices[0].y;
+    for (u64 i = 1; i < vertex_count; i++)
+    {
+        top = min(top, vertices[i].y);
+        bottom = max(bottom, vertices[i].y);
+    }
+    auto first_row = max(top >> 16, (s64)0);
+    auto end_row = min((bottom >> 16) + 1, (s64)image.height);
+    for (auto y = first_row; y < end_row; y++)
+    {
+        auto center_y = y * RENDERER_FIXED_ONE + RENDERER_FIXED_HALF;
+        s64 left = 0;
+        s64 right = 0;
+        bool is_crossed = false;
+        for (u64 i = 0; i < vertex_count; i++)
         {
-            for (u64 x = 0; x < width; x++)
+            auto from = vertices[i];
+            auto to = vertices[(i + 1) % vertex_count];
+            if ((from.y <= center_y) == (to.y <= center_y))
             {
-                data[y * width + x] = color;
+                continue;
+            }
+            s64 x;
+            s64 product;
+            if (!__builtin_mul_overflow(center_y - from.y, to.x - from.x, &product))
+            {
+                x = from.x + product / (to.y - from.y);
+            }
+            else
+            { // an edge tens of thousands of pixels long and wide, through the 16.16 slope instead
+                x = from.x + ((center_y - from.y) * ((to.x - from.x) * RENDERER_FIXED_ONE / (to.y - from.y)) >> 16);
             }
+            left = is_crossed ? min(left, x) : x;
+            right = is_crossed ? max(right, x) : x;
+            is_crossed = true;
+        }
+        if (is_crossed)
+        {
+            // the first and the last pixel whose centers are in [left, right)
+            auto start_x = (left - RENDERER_FIXED_HALF + RENDERER_FIXED_ONE - 1) >> 16;
+            auto end_x = (right - RENDERER_FIXED_HALF + RENDERER_FIXED_ONE - 1) >> 16;
+            render_span(image, y, start_x, end_x, color);
         }
     }
-};
+}
+
+// `width` pixels wide, with square ends cut off at `start` and `end`
+void render_thick_line(ImageView image, Vector2<u64> start, Vector2<u64> end, u64 width, Pixel color)
+{
+    if (width <= 1)
+    {
+        render_line(image, start, end, color);
+        return;
+    }
+    auto zone = profile_begin("render_thick_line");
+    s64 delta_x = (s64)end.x - (s64)start.x;
+    s64 delta_y = (s64)end.y - (s64)start.y;
+    if (delta_x == 0 && delta_y == 0)
+    {
+        delta_x = 1; // a dot is a square
+    }
+    // 16.16, with as many of the fraction bits as the squared length leaves room for, all of them up to 65535 pixels
+    auto squared_length = (u64)(delta_x * delta_x + delta_y * delta_y);
+    auto fraction_bits = min((u64)16, (u64)__builtin_clzll(squared_length) / 2);
+    auto length = (s64)(get_integer_square_root(squared_length << (fraction_bits * 2)) << (16 - fraction_bits));
+    // half of the width, perpendicular to the line
+    auto offset_x = -delta_y * (s64)width * RENDERER_FIXED_ONE / 2 * RENDERER_FIXED_ONE / length;
+    auto offset_y = delta_x * (s64)width * RENDERER_FIXED_ONE / 2 * RENDERER_FIXED_ONE / length;
+    // the ends are pixel centers
+    auto start_x = (s64)start.x * RENDERER_FIXED_ONE + RENDERER_FIXED_HALF;
+    auto start_y = (s64)start.y * RENDERER_FIXED_ONE + RENDERER_FIXED_HALF;
+    auto end_x = (s64)end.x * RENDERER_FIXED_ONE + RENDERER_FIXED_HALF;
+    auto end_y = (s64)end.y * RENDERER_FIXED_ONE + RENDERER_FIXED_HALF;
+    if (start.x == end.x && start.y == end.y)
+    {
+        start_x -= offset_y;
+        end_x += offset_y;
+    }
+    Vector2<s64> corners[] = {
+        Vector2<s64>::construct(start_x + offset_x, start_y + offset_y),
+        Vector2<s64>::construct(end_x + offset_x, end_y + offset_y),
+        Vector2<s64>::construct(end_x - offset_x, end_y - offset_y),
+        Vector2<s64>::construct(start_x - offset_x, start_y - offset_y),
+    };
+    render_convex_polygon(image, corners, 4, color);
+    profile_end(zone);
+}
+
+// how many pixels of row `y` a corner of `radius` cuts off on each side, in a box `height` rows tall
+u64 get_corner_inset(u64 radius, u64 height, u64 y)
+{
+    auto edge_distance = min(y, height - 1 - y);
+    if (edge_distance >= radius)
+    {
+        return 0;
+    }
+    // in half pixels: from the corner circle's center to the row's center, then from there to the circle
+    auto center_distance = radius * 2 - (edge_distance * 2 + 1);
+    auto extent = get_integer_square_root(radius * radius * 4 - center_distance * center_distance);
+    return (radius * 2 - extent) / 2;
+}
+
+// two spans per row of the sides, one per row of the top and the bottom
+void render_rounded_box_spans(ImageView image, Vector2<u64> position, Vector2<u64> dimensions, u64 radius, u64 border_width, Pixel color)
+{
+    if (dimensions.x == 0 || dimensions.y == 0)
+    {
+        return;
+    }
+    radius = min(radius, min(dimensions.x, dimensions.y) / 2);
+    auto inner_radius = radius > border_width ? radius - border_width : 0;
+    auto end_row = min(dimensions.y, image.height > position.y ? image.height - position.y : 0);
+    for (u64 y = 0; y < end_row; y++)
+    {
+        auto outer_inset = get_corner_inset(radius, dimensions.y, y);
+        s64 row_y = position.y + y;
+        s64 left = position.x;
+        s64 right = position.x + dimensions.x;
+        if (y < border_width || y >= dimensions.y - border_width)
+        {
+            render_span(image, row_y, left + outer_inset, right - outer_inset, color);
+            continue;
+        }
+        auto inner_inset = border_width + get_corner_inset(inner_radius, dimensions.y - border_width * 2, y - border_width);
+        inner_inset = max(inner_inset, outer_inset);
+        if (inner_inset * 2 >= dimensions.x)
+        {
+            render_span(image, row_y, left + outer_inset, right - outer_inset, color);
+            continue;
+        }
+        render_span(image, row_y, left + outer_inset, left + inner_inset, color);
+        render_span(image, row_y, right - inner_inset, right - outer_inset, color);
+    }
+}
+
+// an outline `border_width` pixels wide, inside of `dimensions`
+void render_box(ImageView image, Vector2<u64> position, Vector2<u64> dimensions, u64 border_width, Pixel color)
+{
+    auto zone = profile_begin("render_box");
+    render_rounded_box_spans(image, position, dimensions, 0, border_width, color);
+    profile_end(zone);
+}
+
+void render_rounded_box(ImageView image, Vector2<u64> position, Vector2<u64> dimensions, u64 radius, u64 border_width, Pixel color)
+{
+    auto zone = profile_begin("render_rounded_box");
+    render_rounded_box_spans(image, position, dimensions, radius, border_width, color);
+    profile_end(zone);
+}
+
+void render_filled_rounded_box(ImageView image, Vector2<u64> position, Vector2<u64> dimensions, u64 radius, Pixel color)
+{
+    auto zone = profile_begin("render_filled_rounded_box");
+    render_rounded_box_spans(image, position, dimensions, radius, dimensions.y, color);
+    profile_end(zone);
+}
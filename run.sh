@@ -2,4 +2,8 @@ set -ex
 COMPILER_FLAGS='-I /home/levant/doc/plain/code/c++ -Werror -nostdinc -nostdlib -mno-sse -fno-exceptions'
 g++ -O2 $COMPILER_FLAGS main.cpp -o main.bin
 g++ -g $COMPILER_FLAGS main.cpp -o debug.bin
+g++ -O2 $COMPILER_FLAGS benchmark.cpp -o benchmark.bin # not run here, ./benchmark.bin doesn't need a display
+g++ -O2 $COMPILER_FLAGS offscreen.cpp -o offscreen.bin # neither does ./offscreen.bin
+g++ -O2 $COMPILER_FLAGS mock_x11_load_test.cpp -o mock_x11_load_test.bin # nor ./mock_x11_load_test.bin
+g++ -O2 $COMPILER_FLAGS x11_trace_decode.cpp -o x11_trace_decode.bin # ./x11_trace_decode.bin [trace file] after tracing with F9
 ./main.bin
@@ -0,0 +1,237 @@
+// thin wrappers for the syscalls that mystd doesn't expose (yet)
+
+enum LinuxSyscall : u64
+{
+    LinuxSyscallOpen = 2,
+    LinuxSyscallFileStatus = 5,
+    LinuxSyscallMapMemory = 9,
+    LinuxSyscallUnmapMemory = 11,
+    LinuxSyscallMemoryAdvice = 28,
+    LinuxSyscallWriteVector = 20,
+    LinuxSyscallSendTo = 44,
+    LinuxSyscallSocketPair = 53,
+    LinuxSyscallFork = 57,
+    LinuxSyscallWait4 = 61,
+    LinuxSyscallUnlink = 87,
+    LinuxSyscallLockMemory = 149,
+    LinuxSyscallClockGetTime = 228,
+};
+
+s64 raw_syscall(LinuxSyscall number, u64 arg1 = 0, u64 arg2 = 0, u64 arg3 = 0, u64 arg4 = 0, u64 arg5 = 0, u64 arg6 = 0)
+{
+    s64 result;
+    register u64 r10 asm("r10") = arg4;
+    register u64 r8 asm("r8") = arg5;
+    register u64 r9 asm("r9") = arg6;
+    asm volatile(
+        "syscall"
+        : "=a"(result)
+        : "a"(number), "D"(arg1), "S"(arg2), "d"(arg3), "r"(r10), "r"(r8), "r"(r9)
+        : "rcx", "r11", "memory"
+    );
+    return result; // negative values are -errno
+}
+
+const u64 LINUX_OPEN_READ_ONLY = 0;
+const u64 LINUX_OPEN_WRITE_ONLY = 0x1;
+const u64 LINUX_OPEN_CREATE = 0x40;
+const u64 LINUX_OPEN_TRUNCATE = 0x200;
+const u64 LINUX_PROTECTION_READ = 0x1;
+const u64 LINUX_PROTECTION_WRITE = 0x2;
+const u64 LINUX_MAP_PRIVATE = 0x02;
+const u64 LINUX_MAP_ANONYMOUS = 0x20;
+const u64 LINUX_MAP_HUGE_TLB = 0x40000;
+const u64 LINUX_MEMORY_ADVICE_HUGE_PAGE = 14;
+
+Option<Descriptor> open_file_read_only(CStringView path)
+{
+    auto result = raw_syscall(LinuxSyscallOpen, (u64)path, LINUX_OPEN_READ_ONLY);
+    if (result < 0)
+    {
+        return Option<Descriptor>::empty();
+    }
+    return Option<Descriptor>::construct((Descriptor)result);
+}
+
+// creates the file if needed, and empties it if it exists
+Option<Descriptor> open_file_for_writing(CStringView path)
+{
+    auto result = raw_syscall(LinuxSyscallOpen, (u64)path, LINUX_OPEN_WRITE_ONLY | LINUX_OPEN_CREATE | LINUX_OPEN_TRUNCATE, 0644);
+    if (result < 0)
+    {
+        return Option<Descriptor>::empty();
+    }
+    return Option<Descriptor>::construct((Descriptor)result);
+}
+
+bool delete_file(CStringView path)
+{
+    return raw_syscall(LinuxSyscallUnlink, (u64)path) == 0;
+}
+
+Option<u64> get_file_size(Descriptor descriptor)
+{
+    byte file_status[144]; // struct stat on x86_64
+    auto result = raw_syscall(LinuxSyscallFileStatus, (u64)descriptor, (u64)file_status);
+    if (result < 0)
+    {
+        return Option<u64>::empty();
+    }
+    return Option<u64>::construct(*(u64*)(file_status + 48)); // st_size
+}
+
+byte* map_memory(u64 size, u64 protection, u64 flags, Descriptor descriptor = -1, u64 offset = 0)
+{
+    auto result = raw_syscall(LinuxSyscallMapMemory, 0, size, protection, flags, (u64)(s64)descriptor, offset);
+    if (result < 0 && result > -4096)
+    {
+        return nullptr;
+    }
+    return (byte*)result;
+}
+
+void unmap_memory(void* address, u64 size)
+{
+    raw_syscall(LinuxSyscallUnmapMemory, (u64)address, size);
+}
+
+bool advise_memory(void* address, u64 size, u64 advice)
+{
+    return raw_syscall(LinuxSyscallMemoryAdvice, (u64)address, size, advice) == 0;
+}
+
+// keeps the pages resident, fails beyond RLIMIT_MEMLOCK
+bool lock_memory(void* address, u64 size)
+{
+    return raw_syscall(LinuxSyscallLockMemory, (u64)address, size) == 0;
+}
+
+const u64 LINUX_MAX_IO_VECTOR_COUNT = 1024; // IOV_MAX
+
+struct IoVector
+{
+    void* data;
+    u64 size;
+};
+
+// writes the pieces one after another with a single syscall, returns the number of bytes written, negative on error
+s64 write_vector(Descriptor descriptor, IoVector* pieces, u64 count)
+{
+    assert(count <= LINUX_MAX_IO_VECTOR_COUNT, "write_vector: too many pieces: ", count);
+    return raw_syscall(LinuxSyscallWriteVector, (u64)descriptor, (u64)pieces, count);
+}
+
+const u64 LINUX_ADDRESS_FAMILY_UNIX = 1;
+const u64 LINUX_SOCKET_STREAM = 1;
+
+// two connected unix stream sockets, whatever is written into one can be read from the other
+bool create_socket_pair(Descriptor* first, Descriptor* second)
+{
+    s32 descriptors[2];
+    auto result = raw_syscall(LinuxSyscallSocketPair, LINUX_ADDRESS_FAMILY_UNIX, LINUX_SOCKET_STREAM, 0, (u64)descriptors);
+    if (result < 0)
+    {
+        return false;
+    }
+    *first = descriptors[0];
+    *second = descriptors[1];
+    return true;
+}
+
+const u64 LINUX_MESSAGE_NO_SIGNAL = 0x4000;
+
+// like write, but a peer that has hung up is an error instead of a SIGPIPE that kills the process
+s64 send_without_signal(Descriptor socket, void* data, u64 size)
+{
+    return raw_syscall(LinuxSyscallSendTo, (u64)socket, (u64)data, size, LINUX_MESSAGE_NO_SIGNAL, 0, 0);
+}
+
+const u64 LINUX_MESSAGE_DONT_WAIT = 0x40;
+const s64 LINUX_ERROR_AGAIN = -11; // EAGAIN
+
+// sends only as much as the socket's buffer takes right now, LINUX_ERROR_AGAIN when that's nothing
+s64 send_without_blocking(Descriptor socket, void* data, u64 size)
+{
+    return raw_syscall(LinuxSyscallSendTo, (u64)socket, (u64)data, size, LINUX_MESSAGE_NO_SIGNAL | LINUX_MESSAGE_DONT_WAIT, 0, 0);
+}
+
+// returns 0 in the child and the child's pid in the parent, negative on error
+s64 fork_process()
+{
+    return raw_syscall(LinuxSyscallFork);
+}
+
+void wait_for_process(s64 pid)
+{
+    raw_syscall(LinuxSyscallWait4, (u64)pid, 0, 0, 0);
+}
+
+// there's no argv in _start, the kernel has the command line though; arguments are zero-terminated
+Option<CStringView> get_command_line_argument(u64 index)
+{
+    auto command_line = read_whole_file("/proc/self/cmdline").unwrap("Failed to read /proc/self/cmdline");
+    u64 start = 0;
+    for (u64 i = 0; i < command_line.size; i++)
+    {
+        if (command_line.data[i] != 0)
+        {
+            continue;
+        }
+        if (index == 0)
+        {
+            return Option<CStringView>::construct(command_line.data + start); // the command line is never freed
+        }
+        index--;
+        start = i + 1;
+    }
+    return Option<CStringView>::empty();
+}
+
+const u64 LINUX_CLOCK_MONOTONIC = 1;
+
+// in nanoseconds
+u64 get_monotonic_time()
+{
+    s64 time_spec[2]; // seconds, nanoseconds
+    raw_syscall(LinuxSyscallClockGetTime, LINUX_CLOCK_MONOTONIC, (u64)time_spec);
+    return time_spec[0] * 1000 * 1000 * 1000 + time_spec[1];
+}
+
+// a read-only view of a whole file, pages are only read in when touched
+struct MappedFile
+{
+    byte* data;
+    u64 size;
+
+    static Option<MappedFile> open(CStringView path)
+    {
+        auto maybe_descriptor = open_file_read_only(path);
+        if (!maybe_descriptor.has_data)
+        {
+            return Option<MappedFile>::empty();
+        }
+        auto descriptor = maybe_descriptor.value;
+
+        auto maybe_size = get_file_size(descriptor);
+        if (!maybe_size.has_data || maybe_size.value == 0)
+        {
+            close(descriptor);
+            return Option<MappedFile>::empty();
+        }
+
+        MappedFile result;
+        result.size = maybe_size.value;
+        result.data = map_memory(result.size, LINUX_PROTECTION_READ, LINUX_MAP_PRIVATE, descriptor);
+        close(descriptor); // the mapping keeps its own reference to the file
+        if (result.data == nullptr)
+        {
+            return Option<MappedFile>::empty();
+        }
+        return Option<MappedFile>::construct(result);
+    }
+
+    void dispose()
+    {
+        unmap_memory(data, size);
+    }
+};
@@ -1,8 +1,9 @@
 const u64 GLYPH_WIDTH = 8;
 const u64 GLYPH_HEIGHT = 16;
 
-// TODO: these can be arrays of 16 u8-s
-u32 letter_a[GLYPH_HEIGHT * GLYPH_WIDTH] =
+// glyphs are drawn here as 0/1 pixels for readability, they only exist at compile time
+// and get packed into GLYPH_TABLE below
+constexpr u32 letter_a[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 1, 1, 0, 0, 0,
@@ -22,7 +23,7 @@ u32 letter_a[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_b[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_b[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 0, 0,
@@ -42,7 +43,7 @@ u32 letter_b[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_c[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_c[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 1, 0,
@@ -62,7 +63,7 @@ u32 letter_c[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_d[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_d[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 0, 0,
@@ -82,7 +83,7 @@ u32 letter_d[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_e[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_e[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 1, 0,
@@ -102,7 +103,7 @@ u32 letter_e[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_f[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_f[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 1, 0,
@@ -122,7 +123,7 @@ u32 letter_f[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_g[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_g[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 1, 1, 0, 0, 0,
@@ -142,7 +143,7 @@ u32 letter_g[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_h[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_h[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 1, 0,
@@ -162,7 +163,7 @@ u32 letter_h[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_i[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_i[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 1, 0,
@@ -182,7 +183,7 @@ u32 letter_i[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_j[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_j[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 1, 0,
@@ -202,7 +203,7 @@ u32 letter_j[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_k[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_k[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 1, 0,
@@ -222,7 +223,7 @@ u32 letter_k[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_l[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_l[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 0, 0,
@@ -242,7 +243,7 @@ u32 letter_l[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_m[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_m[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 1, 0,
@@ -262,7 +263,7 @@ u32 letter_m[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_n[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_n[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 1, 0,
@@ -282,7 +283,7 @@ u32 letter_n[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_o[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_o[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -302,7 +303,7 @@ u32 letter_o[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_p[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_p[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 0, 0,
@@ -322,7 +323,7 @@ u32 letter_p[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_q[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_q[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -342,7 +343,7 @@ u32 letter_q[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_r[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_r[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 0, 0,
@@ -362,7 +363,7 @@ u32 letter_r[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_s[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_s[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -382,7 +383,7 @@ u32 letter_s[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_t[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_t[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 1, 0,
@@ -402,7 +403,7 @@ u32 letter_t[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_u[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_u[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 1, 0,
@@ -422,7 +423,7 @@ u32 letter_u[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_v[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_v[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 1, 0,
@@ -442,7 +443,7 @@ u32 letter_v[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_w[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_w[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 1, 0,
@@ -462,7 +463,7 @@ u32 letter_w[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_x[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_x[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 1, 0,
@@ -482,7 +483,7 @@ u32 letter_x[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 letter_y[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_y[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 1, 0,
@@ -502,7 +503,7 @@ u32 letter_y[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 1, 1, 0, 0, 0,
 };
 
-u32 letter_z[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 letter_z[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 1, 0,
@@ -522,7 +523,7 @@ u32 letter_z[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 space_glyph[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 space_glyph[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -542,7 +543,7 @@ u32 space_glyph[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 exclamation_glyph[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 exclamation_glyph[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 1, 1, 0, 0, 0,
@@ -562,7 +563,7 @@ u32 exclamation_glyph[GLYPH_HEIGHT * GLYPH_WIDTH] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 double_quotes_glyph[GLYPH_HEIGHT * GLYPH_WIDTH] =
+constexpr u32 double_quotes_glyph[GLYPH_HEIGHT * GLYPH_WIDTH] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 0, 0, 1, 1, 0,
@@ -583,7 +584,7 @@ u32 double_quotes_glyph[GLYPH_HEIGHT * GLYPH_WIDTH] =
 };
 
 
-u32 hashtag_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 hashtag_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 0, 0, 1, 0, 0,
@@ -603,7 +604,7 @@ u32 hashtag_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 dollarsign_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 dollarsign_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 1, 1, 0, 0, 0,
@@ -623,7 +624,7 @@ u32 dollarsign_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 percent_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 percent_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 0, 0, 1, 0,
@@ -643,7 +644,7 @@ u32 percent_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 ampersand_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 ampersand_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 0, 0, 0,
@@ -663,7 +664,7 @@ u32 ampersand_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 single_quote_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 single_quote_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 1, 1, 0, 0, 0,
@@ -683,7 +684,7 @@ u32 single_quote_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 open_paren_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 open_paren_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 1, 0, 0, 0,
@@ -703,7 +704,7 @@ u32 open_paren_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 close_paren_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 close_paren_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 1, 0, 0, 0, 0,
@@ -723,7 +724,7 @@ u32 close_paren_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 asterisk_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 asterisk_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -743,7 +744,7 @@ u32 asterisk_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 plus_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 plus_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -763,7 +764,7 @@ u32 plus_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 comma_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 comma_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -783,7 +784,7 @@ u32 comma_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 minus_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 minus_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -803,7 +804,7 @@ u32 minus_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 dot_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 dot_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -823,7 +824,7 @@ u32 dot_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 forward_slash_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 forward_slash_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 1, 0,
@@ -843,7 +844,7 @@ u32 forward_slash_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 zero_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 zero_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -863,7 +864,7 @@ u32 zero_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 one_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 one_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 1, 1, 0, 0, 0,
@@ -883,7 +884,7 @@ u32 one_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 two_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 two_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -903,7 +904,7 @@ u32 two_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 three_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 three_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -923,7 +924,7 @@ u32 three_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 four_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 four_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 1, 0, 0,
@@ -943,7 +944,7 @@ u32 four_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 five_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 five_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 1, 0,
@@ -963,7 +964,7 @@ u32 five_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 six_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 six_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -983,7 +984,7 @@ u32 six_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 seven_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 seven_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 1, 0,
@@ -1003,7 +1004,7 @@ u32 seven_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 eight_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 eight_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -1023,7 +1024,7 @@ u32 eight_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 nine_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 nine_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -1043,7 +1044,7 @@ u32 nine_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 colon_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 colon_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -1063,7 +1064,7 @@ u32 colon_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 semicolon_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 semicolon_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -1083,7 +1084,7 @@ u32 semicolon_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 less_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 less_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 1, 0,
@@ -1103,7 +1104,7 @@ u32 less_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 equals_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 equals_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -1123,7 +1124,7 @@ u32 equals_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 greater_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 greater_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 0, 0,
@@ -1143,7 +1144,7 @@ u32 greater_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 question_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 question_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -1163,7 +1164,7 @@ u32 question_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 at_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 at_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 1, 1, 1, 1, 0, 0,
@@ -1183,7 +1184,7 @@ u32 at_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 open_bracket_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 open_bracket_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 1, 1, 1, 0,
@@ -1203,7 +1204,7 @@ u32 open_bracket_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 backslash_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 backslash_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 1, 0,
@@ -1223,7 +1224,7 @@ u32 backslash_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 close_bracket_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 close_bracket_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 0, 0, 0, 0,
@@ -1243,7 +1244,7 @@ u32 close_bracket_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 carrot_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 carrot_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 1, 1, 0, 0, 0,
@@ -1263,7 +1264,7 @@ u32 carrot_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 underscore_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 underscore_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -1283,7 +1284,7 @@ u32 underscore_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 backtick_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 backtick_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 0, 0, 0, 0, 0, 0,
@@ -1303,7 +1304,7 @@ u32 backtick_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 curly_open_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 curly_open_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 1, 1, 0,
@@ -1323,7 +1324,7 @@ u32 curly_open_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 pipe_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 pipe_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 1, 1, 0, 0, 0,
@@ -1343,7 +1344,7 @@ u32 pipe_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 curly_close_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 curly_close_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 0, 0, 0, 0, 0,
@@ -1363,7 +1364,7 @@ u32 curly_close_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32 tilde_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
+constexpr u32 tilde_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
 {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -1383,159 +1384,434 @@ u32 tilde_glyph[GLYPH_WIDTH * GLYPH_HEIGHT] =
     0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-u32* font_map[127];
-
-void initialize_fonts()
-{
-    font_map['a'] = letter_a;
-    font_map['A'] = letter_a;
-    font_map['b'] = letter_b;
-    font_map['B'] = letter_b;
-    font_map['c'] = letter_c;
-    font_map['C'] = letter_c;
-    font_map['d'] = letter_d;
-    font_map['D'] = letter_d;
-    font_map['d'] = letter_d;
-    font_map['D'] = letter_d;
-    font_map['e'] = letter_e;
-    font_map['E'] = letter_e;
-    font_map['f'] = letter_f;
-    font_map['F'] = letter_f;
-    font_map['g'] = letter_g;
-    font_map['G'] = letter_g;
-    font_map['h'] = letter_h;
-    font_map['H'] = letter_h;
-    font_map['i'] = letter_i;
-    font_map['I'] = letter_i;
-    font_map['j'] = letter_j;
-    font_map['J'] = letter_j;
-    font_map['k'] = letter_k;
-    font_map['K'] = letter_k;
-    font_map['l'] = letter_l;
-    font_map['L'] = letter_l;
-    font_map['m'] = letter_m;
-    font_map['M'] = letter_m;
-    font_map['n'] = letter_n;
-    font_map['N'] = letter_n;
-    font_map['o'] = letter_o;
-    font_map['O'] = letter_o;
-    font_map['p'] = letter_p;
-    font_map['P'] = letter_p;
-    font_map['q'] = letter_q;
-    font_map['Q'] = letter_q;
-    font_map['r'] = letter_r;
-    font_map['R'] = letter_r;
-    font_map['s'] = letter_s;
-    font_map['S'] = letter_s;
-    font_map['t'] = letter_t;
-    font_map['T'] = letter_t;
-    font_map['u'] = letter_u;
-    font_map['U'] = letter_u;
-    font_map['v'] = letter_v;
-    font_map['V'] = letter_v;
-    font_map['w'] = letter_w;
-    font_map['W'] = letter_w;
-    font_map['x'] = letter_x;
-    font_map['X'] = letter_x;
-    font_map['y'] = letter_y;
-    font_map['Y'] = letter_y;
-    font_map['z'] = letter_z;
-    font_map['Z'] = letter_z;
-    font_map[' '] = space_glyph;
-    font_map['!'] = exclamation_glyph;
-    font_map['"'] = double_quotes_glyph;
-    font_map['#'] = hashtag_glyph;
-    font_map['$'] = dollarsign_glyph;
-    font_map['%'] = percent_glyph;
-    font_map['&'] = ampersand_glyph;
-    font_map['\''] = single_quote_glyph;
-    font_map['('] = open_paren_glyph;
-    font_map[')'] = close_paren_glyph;
-    font_map['*'] = asterisk_glyph;
-    font_map['+'] = plus_glyph;
-    font_map[','] = comma_glyph;
-    font_map['-'] = minus_glyph;
-    font_map['.'] = dot_glyph;
-    font_map['/'] = forward_slash_glyph;
-    font_map['0'] = zero_glyph;
-    font_map['1'] = one_glyph;
-    font_map['2'] = two_glyph;
-    font_map['3'] = three_glyph;
-    font_map['4'] = four_glyph;
-    font_map['5'] = five_glyph;
-    font_map['6'] = six_glyph;
-    font_map['7'] = seven_glyph;
-    font_map['8'] = eight_glyph;
-    font_map['9'] = nine_glyph;
-    font_map[':'] = colon_glyph;
-    font_map[';'] = semicolon_glyph;
-    font_map['<'] = less_glyph;
-    font_map['='] = equals_glyph;
-    font_map['>'] = greater_glyph;
-    font_map['?'] = question_glyph;
-    font_map['@'] = at_glyph;
-    font_map['['] = open_bracket_glyph;
-    font_map['\\'] = backslash_glyph;
-    font_map[']'] = close_bracket_glyph;
-    font_map['^'] = carrot_glyph;
-    font_map['_'] = underscore_glyph;
-    font_map['`'] = backtick_glyph;
-    font_map['{'] = curly_open_glyph;
-    font_map['|'] = pipe_glyph;
-    font_map['}'] = curly_close_glyph;
-    font_map['~'] = tilde_glyph;
+struct GlyphRows
+{
+    u8 rows[GLYPH_HEIGHT]; // bit 7 is the leftmost pixel
+};
+
+typedef CodepointPage<GlyphRows> GlyphPage;
+
+constexpr void bake_glyph(GlyphPage* page, char character, const u32* pixels)
+{
+    for (u64 y = 0; y < GLYPH_HEIGHT; y++)
+    {
+        u8 row = 0;
+        for (u64 x = 0; x < GLYPH_WIDTH; x++)
+        {
+            row |= pixels[y * GLYPH_WIDTH + x] << (GLYPH_WIDTH - 1 - x);
+        }
+        page->values[(u64)character].rows[y] = row;
+    }
+    page->is_mapped[character / 64] |= 1ull << (character % 64);
 }
 
-void render_text(
-    String text,
-    Pixel text_color,
-    Image image,
-    Vector2<u64> position,
-    u64 size
-)
+constexpr GlyphPage bake_ascii_glyph_page()
+{
+    GlyphPage result = {};
+    bake_glyph(&result, 'a', letter_a);
+    bake_glyph(&result, 'A', letter_a);
+    bake_glyph(&result, 'b', letter_b);
+    bake_glyph(&result, 'B', letter_b);
+    bake_glyph(&result, 'c', letter_c);
+    bake_glyph(&result, 'C', letter_c);
+    bake_glyph(&result, 'd', letter_d);
+    bake_glyph(&result, 'D', letter_d);
+    bake_glyph(&result, 'e', letter_e);
+    bake_glyph(&result, 'E', letter_e);
+    bake_glyph(&result, 'f', letter_f);
+    bake_glyph(&result, 'F', letter_f);
+    bake_glyph(&result, 'g', letter_g);
+    bake_glyph(&result, 'G', letter_g);
+    bake_glyph(&result, 'h', letter_h);
+    bake_glyph(&result, 'H', letter_h);
+    bake_glyph(&result, 'i', letter_i);
+    bake_glyph(&result, 'I', letter_i);
+    bake_glyph(&result, 'j', letter_j);
+    bake_glyph(&result, 'J', letter_j);
+    bake_glyph(&result, 'k', letter_k);
+    bake_glyph(&result, 'K', letter_k);
+    bake_glyph(&result, 'l', letter_l);
+    bake_glyph(&result, 'L', letter_l);
+    bake_glyph(&result, 'm', letter_m);
+    bake_glyph(&result, 'M', letter_m);
+    bake_glyph(&result, 'n', letter_n);
+    bake_glyph(&result, 'N', letter_n);
+    bake_glyph(&result, 'o', letter_o);
+    bake_glyph(&result, 'O', letter_o);
+    bake_glyph(&result, 'p', letter_p);
+    bake_glyph(&result, 'P', letter_p);
+    bake_glyph(&result, 'q', letter_q);
+    bake_glyph(&result, 'Q', letter_q);
+    bake_glyph(&result, 'r', letter_r);
+    bake_glyph(&result, 'R', letter_r);
+    bake_glyph(&result, 's', letter_s);
+    bake_glyph(&result, 'S', letter_s);
+    bake_glyph(&result, 't', letter_t);
+    bake_glyph(&result, 'T', letter_t);
+    bake_glyph(&result, 'u', letter_u);
+    bake_glyph(&result, 'U', letter_u);
+    bake_glyph(&result, 'v', letter_v);
+    bake_glyph(&result, 'V', letter_v);
+    bake_glyph(&result, 'w', letter_w);
+    bake_glyph(&result, 'W', letter_w);
+    bake_glyph(&result, 'x', letter_x);
+    bake_glyph(&result, 'X', letter_x);
+    bake_glyph(&result, 'y', letter_y);
+    bake_glyph(&result, 'Y', letter_y);
+    bake_glyph(&result, 'z', letter_z);
+    bake_glyph(&result, 'Z', letter_z);
+    bake_glyph(&result, ' ', space_glyph);
+    bake_glyph(&result, '!', exclamation_glyph);
+    bake_glyph(&result, '"', double_quotes_glyph);
+    bake_glyph(&result, '#', hashtag_glyph);
+    bake_glyph(&result, '$', dollarsign_glyph);
+    bake_glyph(&result, '%', percent_glyph);
+    bake_glyph(&result, '&', ampersand_glyph);
+    bake_glyph(&result, '\'', single_quote_glyph);
+    bake_glyph(&result, '(', open_paren_glyph);
+    bake_glyph(&result, ')', close_paren_glyph);
+    bake_glyph(&result, '*', asterisk_glyph);
+    bake_glyph(&result, '+', plus_glyph);
+    bake_glyph(&result, ',', comma_glyph);
+    bake_glyph(&result, '-', minus_glyph);
+    bake_glyph(&result, '.', dot_glyph);
+    bake_glyph(&result, '/', forward_slash_glyph);
+    bake_glyph(&result, '0', zero_glyph);
+    bake_glyph(&result, '1', one_glyph);
+    bake_glyph(&result, '2', two_glyph);
+    bake_glyph(&result, '3', three_glyph);
+    bake_glyph(&result, '4', four_glyph);
+    bake_glyph(&result, '5', five_glyph);
+    bake_glyph(&result, '6', six_glyph);
+    bake_glyph(&result, '7', seven_glyph);
+    bake_glyph(&result, '8', eight_glyph);
+    bake_glyph(&result, '9', nine_glyph);
+    bake_glyph(&result, ':', colon_glyph);
+    bake_glyph(&result, ';', semicolon_glyph);
+    bake_glyph(&result, '<', less_glyph);
+    bake_glyph(&result, '=', equals_glyph);
+    bake_glyph(&result, '>', greater_glyph);
+    bake_glyph(&result, '?', question_glyph);
+    bake_glyph(&result, '@', at_glyph);
+    bake_glyph(&result, '[', open_bracket_glyph);
+    bake_glyph(&result, '\\', backslash_glyph);
+    bake_glyph(&result, ']', close_bracket_glyph);
+    bake_glyph(&result, '^', carrot_glyph);
+    bake_glyph(&result, '_', underscore_glyph);
+    bake_glyph(&result, '`', backtick_glyph);
+    bake_glyph(&result, '{', curly_open_glyph);
+    bake_glyph(&result, '|', pipe_glyph);
+    bake_glyph(&result, '}', curly_close_glyph);
+    bake_glyph(&result, '~', tilde_glyph);
+    return result;
+}
+
+// ASCII is indexed directly, everything else goes through the sparse extended_glyph_map
+constexpr GlyphPage ASCII_GLYPH_PAGE = bake_ascii_glyph_page();
+
+CodepointPage<GlyphRows>* extended_glyph_pages[CODEPOINT_PAGE_COUNT];
+auto extended_glyph_map = CodepointMap<GlyphRows>::construct(extended_glyph_pages);
+
+const u32 FALLBACK_GLYPH_CHARACTER = '?';
+
+const GlyphRows* lookup_glyph(u32 codepoint)
+{
+    if (codepoint < CODEPOINT_PAGE_SIZE)
+    {
+        return ASCII_GLYPH_PAGE.contains(codepoint) ? &ASCII_GLYPH_PAGE.values[codepoint] : nullptr;
+    }
+    return extended_glyph_map.get(codepoint);
+}
+
+const u64 GLYPH_SCALE_MAX_SIZE = 512; // in pixels, the height of a rendered glyph
+const u64 GLYPH_SCALE_CACHE_SIZE = 4;
+
+// maps every output row/column of a glyph rendered at `size` back to the source row/column
+// of the GLYPH_WIDTH x GLYPH_HEIGHT bitmap, so rendering doesn't need to divide
+struct GlyphScale
 {
-    u64 text_i = 0;
-    u64 x = position.x;
-    u64 y = position.y;
-    u64 x_scale = size / GLYPH_WIDTH / 2;
-    u64 y_scale = size / GLYPH_HEIGHT;
-    while (text_i < text.size && x < image.width)
+    u64 size;
+    u64 width; // of a rendered glyph, in pixels
+    u64 height;
+    u8 source_rows[GLYPH_SCALE_MAX_SIZE];
+    u8 column_masks[GLYPH_SCALE_MAX_SIZE * GLYPH_WIDTH / GLYPH_HEIGHT]; // bit of the glyph row to test for each output column
+    u16 ascii_advances[CODEPOINT_PAGE_SIZE];
+
+    u64 get_advance(u32 codepoint)
+    {
+        return codepoint < CODEPOINT_PAGE_SIZE ? ascii_advances[codepoint] : width;
+    }
+
+    void compute(u64 new_size)
     {
-        if (text.data[text_i] == '\n')
+        assert(new_size != 0 && new_size <= GLYPH_SCALE_MAX_SIZE, "GlyphScale::compute: unsupported font size: ", new_size);
+        size = new_size;
+        height = size;
+        width = max(size * GLYPH_WIDTH / GLYPH_HEIGHT, (u64)1);
+
+        // 16.16 fixed point, sampling at pixel centers
+        u64 row_step = (GLYPH_HEIGHT << 16) / height;
+        u64 row_position = row_step / 2;
+        for (u64 y = 0; y < height; y++, row_position += row_step)
         {
-            x = position.x;
-            y += GLYPH_HEIGHT * y_scale;
-            text_i++;
-            continue;
+            source_rows[y] = row_position >> 16;
+        }
+        u64 column_step = (GLYPH_WIDTH << 16) / width;
+        u64 column_position = column_step / 2;
+        for (u64 x = 0; x < width; x++, column_position += column_step)
+        {
+            column_masks[x] = 1 << (GLYPH_WIDTH - 1 - (column_position >> 16));
         }
 
-        auto glyph = font_map[text.data[text_i]];
-        assert(glyph != nullptr, "render_text: unmapped character: ", text.data[text_i]);
-        for (u64 glyph_y = 0; glyph_y < GLYPH_HEIGHT; glyph_y++)
+        // the built-in font is monospace, unmapped characters are drawn with the fallback glyph
+        for (u64 character = 0; character < CODEPOINT_PAGE_SIZE; character++)
         {
-            for (u64 glyph_x = 0; glyph_x < GLYPH_WIDTH; glyph_x++)
+            ascii_advances[character] = character == '\n' ? 0 : width;
+        }
+    }
+};
+
+GlyphScale glyph_scale_cache[GLYPH_SCALE_CACHE_SIZE];
+u64 glyph_scale_cache_next_i;
+
+// the cache starts out zeroed, so a size of 0 would match a slot that was never computed
+GlyphScale* get_glyph_scale(u64 size)
+{
+    assert(size > 0, "get_glyph_scale: the font size has to be positive");
+    for (u64 i = 0; i < GLYPH_SCALE_CACHE_SIZE; i++)
+    {
+        if (glyph_scale_cache[i].size == size)
+        {
+            return &glyph_scale_cache[i];
+        }
+    }
+    auto result = &glyph_scale_cache[glyph_scale_cache_next_i];
+    glyph_scale_cache_next_i = (glyph_scale_cache_next_i + 1) % GLYPH_SCALE_CACHE_SIZE;
+    result->compute(size);
+    return result;
+}
+
+const u64 TEXT_LAYOUT_NO_WRAP = -1;
+const u64 UTF8_CURSOR_LOOKAHEAD = 256; // how far ahead an ASCII run is looked for, the text can be a whole mapped file
+
+struct Utf8Cursor
+{
+    String text;
+    u64 i;
+    u64 ascii_run_end;
+
+    static Utf8Cursor construct(String text, u64 i)
+    {
+        Utf8Cursor result;
+        result.text = text;
+        result.i = i;
+        result.ascii_run_end = i;
+        return result;
+    }
+
+    bool has_next()
+    {
+        return i < text.size;
+    }
+
+    u32 peek(u64* size)
+    {
+        if (i >= ascii_run_end)
+        {
+            ascii_run_end = i + count_ascii_prefix((byte*)text.data + i, min(text.size - i, UTF8_CURSOR_LOOKAHEAD));
+        }
+        if (i < ascii_run_end)
+        {
+            *size = 1;
+            return text.data[i];
+        }
+        auto decoded = decode_utf8_codepoint((byte*)text.data + i, text.size - i);
+        *size = decoded.size;
+        return decoded.codepoint;
+    }
+
+    u32 next()
+    {
+        u64 size;
+        auto result = peek(&size);
+        i += size;
+        return result;
+    }
+};
+
+struct TextLine
+{
+    u32 start; // byte offset into the text
+    u32 size; // in bytes, without the line break
+    u32 width; // in pixels
+};
+
+struct TextLineBreak
+{
+    TextLine line;
+    u64 next_start;
+    bool is_hard; // the line ended with '\n'
+};
+
+// greedy: a line takes as many glyphs as fit into max_width, but always at least one
+TextLineBreak layout_next_line(String text, u64 start, u64 max_width, GlyphScale* scale)
+{
+    TextLineBreak result;
+    result.line.start = start;
+    result.line.width = 0;
+    result.is_hard = false;
+    auto cursor = Utf8Cursor::construct(text, start);
+    while (cursor.has_next())
+    {
+        u64 codepoint_size;
+        auto codepoint = cursor.peek(&codepoint_size);
+        if (codepoint == '\n')
+        {
+            result.line.size = cursor.i - start;
+            result.next_start = cursor.i + 1;
+            result.is_hard = true;
+            return result;
+        }
+        auto advance = scale->get_advance(codepoint);
+        if (result.line.width + advance > max_width && cursor.i != start)
+        {
+            break;
+        }
+        result.line.width += advance;
+        cursor.i += codepoint_size;
+    }
+    result.line.size = cursor.i - start;
+    result.next_start = cursor.i;
+    return result;
+}
+
+// size of the text's bounding box, in pixels
+Vector2<u64> measure_text(String text, u64 size, u64 max_width = TEXT_LAYOUT_NO_WRAP)
+{
+    auto scale = get_glyph_scale(size);
+    auto result = Vector2<u64>::construct(0, 0);
+    u64 start = 0;
+    while (true)
+    {
+        auto line_break = layout_next_line(text, start, max_width, scale);
+        result.x = max(result.x, (u64)line_break.line.width);
+        result.y += scale->height;
+        if (!line_break.is_hard && line_break.next_start >= text.size)
+        {
+            return result;
+        }
+        start = line_break.next_start;
+    }
+}
+
+void render_text_line(String text, TextLine line, Pixel text_color, ImageView image, Vector2<u64> position, GlyphScale* scale)
+{
+    auto x = position.x;
+    auto cursor = Utf8Cursor::construct(text, line.start);
+    while (cursor.i < (u64)line.start + line.size)
+    {
+        auto codepoint = cursor.next();
+        auto glyph = lookup_glyph(codepoint);
+        if (glyph == nullptr)
+        {
+            glyph = lookup_glyph(FALLBACK_GLYPH_CHARACTER);
+        }
+        for (u64 glyph_y = 0; glyph_y < scale->height; glyph_y++)
+        {
+            auto row = glyph->rows[scale->source_rows[glyph_y]];
+            if (row == 0)
+            {
+                continue;
+            }
+            auto image_row = image.get_row(position.y + glyph_y) + x;
+            for (u64 glyph_x = 0; glyph_x < scale->width; glyph_x++)
             {
-                auto glyph_pixel_i = glyph_y * GLYPH_WIDTH + glyph_x;
-                if (glyph[glyph_pixel_i] == 1)
+                if (row & scale->column_masks[glyph_x])
                 {
-                    for (u64 y_scale_i = 0; y_scale_i < y_scale; y_scale_i++)
-                    {
-                        for (u64 x_scale_i = 0; x_scale_i < x_scale; x_scale_i++)
-                        {
-                            auto image_pixel_i = (y + glyph_y * y_scale + y_scale_i) * image.width + x + glyph_x * x_scale + x_scale_i;
-                            image.data[image_pixel_i] = text_color;
-                        }
-                    }
+                    image_row[glyph_x] = text_color;
                 }
             }
         }
+        x += scale->get_advance(codepoint);
+    }
+}
+
+// the glyph's left edge is at `x`, which can be outside of the image; columns outside of it are cut off
+void render_clipped_glyph(const GlyphRows* glyph, Pixel text_color, ImageView image, s64 x, u64 y, GlyphScale* scale)
+{
+    auto first_column = x < 0 ? (u64)-x : 0;
+    auto end_column = (u64)max(min((s64)scale->width, (s64)image.width - x), (s64)0);
+    auto end_row = min(scale->height, image.height > y ? image.height - y : 0);
+    for (u64 glyph_y = 0; glyph_y < end_row; glyph_y++)
+    {
+        auto row = glyph->rows[scale->source_rows[glyph_y]];
+        if (row == 0)
+        {
+            continue;
+        }
+        auto image_row = image.get_row(y + glyph_y) + x;
+        for (auto glyph_x = first_column; glyph_x < end_column; glyph_x++)
+        {
+            if (row & scale->column_masks[glyph_x])
+            {
+                image_row[glyph_x] = text_color;
+            }
+        }
+    }
+}
+
+// a single line starting at `x`, which can be left of the image: glyphs that end left of it are only measured,
+// and drawing stops at its right edge, so the cost goes with what is visible plus what is skipped on the left
+void render_text_run(String text, Pixel text_color, ImageView image, s64 x, u64 y, GlyphScale* scale)
+{
+    auto cursor = Utf8Cursor::construct(text, 0);
+    while (cursor.has_next() && x < (s64)image.width)
+    {
+        auto codepoint = cursor.next();
+        auto advance = scale->get_advance(codepoint);
+        if (x + (s64)scale->width > 0)
+        {
+            auto glyph = lookup_glyph(codepoint);
+            if (glyph == nullptr)
+            {
+                glyph = lookup_glyph(FALLBACK_GLYPH_CHARACTER);
+            }
+            render_clipped_glyph(glyph, text_color, image, x, y, scale);
+        }
+        x += advance;
+    }
+}
 
-        x += GLYPH_WIDTH * x_scale;
-        if (x + GLYPH_WIDTH * x_scale > image.width)
+// lays the text out while drawing it, wrapping at the right edge of the image
+void render_text(
+    String text,
+    Pixel text_color,
+    ImageView image,
+    Vector2<u64> position,
+    u64 size
+)
+{
+    if (position.x >= image.width)
+    {
+        return;
+    }
+    auto zone = profile_begin("render_text");
+    auto scale = get_glyph_scale(size);
+    auto line_position = position;
+    u64 start = 0;
+    while (line_position.y + scale->height <= image.height)
+    {
+        auto line_break = layout_next_line(text, start, image.width - position.x, scale);
+        if (line_break.line.width <= image.width - position.x)
+        {
+            render_text_line(text, line_break.line, text_color, image, line_position, scale);
+        }
+        if (!line_break.is_hard && line_break.next_start >= text.size)
         {
-            x = position.x;
-            y += GLYPH_HEIGHT * y_scale;
+            break;
         }
-        text_i++;
+        start = line_break.next_start;
+        line_position.y += scale->height;
     }
+    profile_end(zone);
 }
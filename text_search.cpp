@@ -0,0 +1,209 @@
+// incremental substring search: every run_slice call scans for at most the given time, so a search
+// through a huge document is spread over many frames, matches become visible as soon as they're found
+
+const u64 TEXT_SEARCH_CHUNK_SIZE = 64 * 1024; // bytes scanned between two clock checks
+const u64 TEXT_SEARCH_DEFAULT_SLICE = 1000 * 1000; // in nanoseconds
+// a highlight per match is all they're for, and a one-byte needle would otherwise grow a list as big as the text
+const u64 TEXT_SEARCH_MAX_MATCHES = 64 * 1024;
+
+// unlike get_matching_bytes this is exact for every byte, not just the lowest match
+u64 get_all_matching_bytes(u64 word, u64 repeated_value)
+{
+    auto difference = word ^ repeated_value;
+    auto low_bits = ~BYTE_SEARCH_HIGH_BITS;
+    return ~(((difference & low_bits) + low_bits) | difference | low_bits);
+}
+
+bool are_bytes_equal(byte* left, byte* right, u64 size)
+{
+    for (u64 i = 0; i < size; i++)
+    {
+        if (left[i] != right[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct TextSearch
+{
+    // the text can be split in two, like the halves of a GapBuffer; offsets are into the concatenation
+    byte* first;
+    u64 first_size;
+    byte* second;
+    u64 second_size;
+    byte* needle; // a copy, owned by the search
+    u64 needle_size;
+    u64 position; // next candidate offset
+    List<u64> matches; // sorted, the renderer can read them at any point
+    u64 max_match_count; // the search stops once it found this many
+
+    // the needle can come in two parts as well, it's copied into one
+    static TextSearch start(
+        byte* first,
+        u64 first_size,
+        byte* second,
+        u64 second_size,
+        String needle_before,
+        String needle_after,
+        u64 max_match_count = TEXT_SEARCH_MAX_MATCHES
+    )
+    {
+        TextSearch result;
+        result.first = first;
+        result.first_size = first_size;
+        result.second = second;
+        result.second_size = second_size;
+        result.needle_size = needle_before.size + needle_after.size;
+        assert(result.needle_size != 0, "TextSearch::start: empty needle");
+        result.needle = heap_allocate(result.needle_size);
+        copy_memory(needle_before.data, needle_before.size, result.needle);
+        copy_memory(needle_after.data, needle_after.size, result.needle + needle_before.size);
+        result.position = 0;
+        result.matches = List<u64>::allocate();
+        result.max_match_count = max_match_count;
+        return result;
+    }
+
+    static TextSearch start(byte* first, u64 first_size, byte* second, u64 second_size, String needle, u64 max_match_count = TEXT_SEARCH_MAX_MATCHES)
+    {
+        String no_needle;
+        no_needle.data = nullptr;
+        no_needle.size = 0;
+        return start(first, first_size, second, second_size, needle, no_needle, max_match_count);
+    }
+
+    static TextSearch start(byte* data, u64 size, String needle, u64 max_match_count = TEXT_SEARCH_MAX_MATCHES)
+    {
+        return start(data, size, nullptr, 0, needle, max_match_count);
+    }
+
+    void deallocate()
+    {
+        default_deallocate(needle);
+        matches.deallocate();
+    }
+
+    u64 get_text_size()
+    {
+        return first_size + second_size;
+    }
+
+    bool is_done()
+    {
+        return position + needle_size > get_text_size() || matches.size >= max_match_count;
+    }
+
+    void add_match(u64 offset)
+    {
+        if (matches.size < max_match_count)
+        {
+            matches.push(offset);
+        }
+    }
+
+    byte get_byte(u64 offset)
+    {
+        return offset < first_size ? first[offset] : second[offset - first_size];
+    }
+
+    // candidates are positions where both the first and the last byte of the needle match,
+    // they're found 8 positions at a time and only then compared in full
+    void scan_contiguous(byte* data, u64 data_size, u64 candidate_count, u64 base_offset)
+    {
+        auto last_i = needle_size - 1;
+        auto repeated_first = BYTE_SEARCH_LOW_BITS * needle[0];
+        auto repeated_last = BYTE_SEARCH_LOW_BITS * needle[last_i];
+        u64 i = 0;
+        while (i + 8 <= candidate_count && i + 8 + last_i <= data_size)
+        {
+            auto candidates = get_all_matching_bytes(*(u64*)(data + i), repeated_first)
+                & get_all_matching_bytes(*(u64*)(data + i + last_i), repeated_last);
+            while (candidates != 0)
+            {
+                auto candidate_i = i + __builtin_ctzll(candidates) / 8;
+                if (are_bytes_equal(data + candidate_i + 1, needle + 1, needle_size > 2 ? needle_size - 2 : 0))
+                {
+                    add_match(base_offset + candidate_i);
+                }
+                candidates &= candidates - 1;
+            }
+            i += 8;
+        }
+        for (; i < candidate_count; i++)
+        {
+            if (data[i] == needle[0] && are_bytes_equal(data + i, needle, needle_size))
+            {
+                add_match(base_offset + i);
+            }
+        }
+    }
+
+    void scan_next_chunk()
+    {
+        auto candidates_end = get_text_size() - needle_size + 1;
+        if (position + needle_size <= first_size)
+        { // entirely inside the first part
+            auto count = min(TEXT_SEARCH_CHUNK_SIZE, first_size - needle_size + 1 - position);
+            scan_contiguous(first + position, first_size - position, count, position);
+            position += count;
+        }
+        else if (position >= first_size)
+        { // entirely inside the second part
+            auto count = min(TEXT_SEARCH_CHUNK_SIZE, candidates_end - position);
+            scan_contiguous(second + (position - first_size), second_size - (position - first_size), count, position);
+            position += count;
+        }
+        else
+        { // straddling the split, there are at most needle_size - 1 of these
+            for (; position < first_size && position < candidates_end; position++)
+            {
+                u64 i = 0;
+                while (i < needle_size && get_byte(position + i) == needle[i])
+                {
+                    i++;
+                }
+                if (i == needle_size)
+                {
+                    add_match(position);
+                }
+            }
+        }
+    }
+
+    // returns true once the whole text has been searched
+    bool run_slice(u64 time_budget = TEXT_SEARCH_DEFAULT_SLICE)
+    {
+        auto deadline = get_monotonic_time() + time_budget;
+        while (!is_done())
+        {
+            scan_next_chunk();
+            if (get_monotonic_time() >= deadline)
+            {
+                break;
+            }
+        }
+        return is_done();
+    }
+
+    // index of the first match at or after offset
+    u64 find_first_match(u64 offset)
+    {
+        u64 low = 0;
+        u64 high = matches.size;
+        while (low < high)
+        {
+            auto middle = (low + high) / 2;
+            if (matches.data[middle] < offset)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        return low;
+    }
+};
@@ -0,0 +1,441 @@
+const u32 UNICODE_REPLACEMENT_CHARACTER = 0xFFFD;
+const u32 UNICODE_MAX_CODEPOINT = 0x10FFFF;
+
+struct Utf8DecodeResult
+{
+    u32 codepoint;
+    u64 size; // number of bytes consumed, always at least 1
+};
+
+// invalid and truncated sequences decode to U+FFFD and consume a single byte so that decoding resynchronizes
+Utf8DecodeResult decode_utf8_codepoint(byte* data, u64 size)
+{
+    Utf8DecodeResult result;
+    result.codepoint = UNICODE_REPLACEMENT_CHARACTER;
+    result.size = 1;
+
+    auto first = data[0];
+    u64 sequence_size;
+    u32 codepoint;
+    u32 minimum;
+    if (first < 0x80)
+    {
+        result.codepoint = first;
+        return result;
+    }
+    else if ((first & 0xE0) == 0xC0)
+    {
+        sequence_size = 2;
+        codepoint = first & 0x1F;
+        minimum = 0x80;
+    }
+    else if ((first & 0xF0) == 0xE0)
+    {
+        sequence_size = 3;
+        codepoint = first & 0x0F;
+        minimum = 0x800;
+    }
+    else if ((first & 0xF8) == 0xF0)
+    {
+        sequence_size = 4;
+        codepoint = first & 0x07;
+        minimum = 0x10000;
+    }
+    else
+    {
+        return result;
+    }
+
+    if (sequence_size > size)
+    {
+        return result;
+    }
+    for (u64 i = 1; i < sequence_size; i++)
+    {
+        if ((data[i] & 0xC0) != 0x80)
+        {
+            return result;
+        }
+        codepoint = (codepoint << 6) | (data[i] & 0x3F);
+    }
+    if (codepoint < minimum || codepoint > UNICODE_MAX_CODEPOINT || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+    { // overlong encodings and surrogates are invalid
+        return result;
+    }
+
+    result.codepoint = codepoint;
+    result.size = sequence_size;
+    return result;
+}
+
+const u64 ASCII_HIGH_BITS = 0x8080808080808080;
+
+// length of the pure ASCII run at the start of data, checked two words, 16 bytes, per iteration
+u64 count_ascii_prefix(byte* data, u64 size)
+{
+    u64 i = 0;
+    while (i + 16 <= size)
+    {
+        auto first = *(u64*)(data + i);
+        auto second = *(u64*)(data + i + 8);
+        if ((first | second) & ASCII_HIGH_BITS)
+        {
+            break;
+        }
+        i += 16;
+    }
+    while (i < size && data[i] < 0x80)
+    {
+        i++;
+    }
+    return i;
+}
+
+// number of bytes at the end that start a sequence which continues past the end,
+// e.g. when text arrives in chunks that were split without regard for UTF-8
+u64 get_incomplete_utf8_suffix_size(byte* data, u64 size)
+{
+    for (u64 suffix_size = 1; suffix_size <= min(size, (u64)3); suffix_size++)
+    {
+        auto first = data[size - suffix_size];
+        if ((first & 0xC0) == 0x80)
+        {
+            continue;
+        }
+        u64 sequence_size = (first & 0xE0) == 0xC0 ? 2 : (first & 0xF0) == 0xE0 ? 3 : (first & 0xF8) == 0xF0 ? 4 : 1;
+        return sequence_size > suffix_size ? suffix_size : 0;
+    }
+    return 0;
+}
+
+// bulk validation and decoding: ASCII runs are skipped 16 bytes at a time, multibyte sequences are checked whole
+// with a single table lookup on their lead byte instead of a byte-at-a-time state machine; on CPUs with AVX2,
+// validation first goes through 32 bytes at a time with the shuffle-based classification further down
+
+struct Utf8LeadInfo
+{
+    u8 sequence_size; // 0 for bytes that can't start a multibyte sequence
+    u8 payload_mask;
+    // the allowed range of the second byte rules out overlong encodings, surrogates and values past U+10FFFF
+    u8 second_min;
+    u8 second_max;
+};
+
+struct Utf8LeadTable
+{
+    Utf8LeadInfo leads[256];
+};
+
+constexpr Utf8LeadTable build_utf8_lead_table()
+{
+    Utf8LeadTable result = {};
+    for (u64 i = 0xC2; i <= 0xF4; i++)
+    {
+        auto lead = &result.leads[i];
+        lead->sequence_size = i < 0xE0 ? 2 : i < 0xF0 ? 3 : 4;
+        lead->payload_mask = i < 0xE0 ? 0x1F : i < 0xF0 ? 0x0F : 0x07;
+        lead->second_min = i == 0xE0 ? 0xA0 : i == 0xF0 ? 0x90 : 0x80;
+        lead->second_max = i == 0xED ? 0x9F : i == 0xF4 ? 0x8F : 0xBF;
+    }
+    return result;
+}
+
+constexpr Utf8LeadTable UTF8_LEAD_TABLE = build_utf8_lead_table();
+
+// size of the valid multibyte sequence at the start of data, 0 if it's invalid or truncated
+u64 get_utf8_sequence_size(byte* data, u64 size)
+{
+    auto lead = UTF8_LEAD_TABLE.leads[data[0]];
+    if (lead.sequence_size == 0 || lead.sequence_size > size)
+    {
+        return 0;
+    }
+    auto second = data[1];
+    auto are_rest_continuations =
+        (lead.sequence_size < 3 || (data[2] & 0xC0) == 0x80) && (lead.sequence_size < 4 || (data[3] & 0xC0) == 0x80);
+    if (second < lead.second_min || second > lead.second_max || !are_rest_continuations)
+    {
+        return 0;
+    }
+    return lead.sequence_size;
+}
+
+// find_invalid_utf8 without AVX2
+u64 find_invalid_utf8_scalar(byte* data, u64 size)
+{
+    u64 i = 0;
+    while (true)
+    {
+        i += count_ascii_prefix(data + i, size - i);
+        if (i == size)
+        {
+            return size;
+        }
+        while (i < size && data[i] >= 0x80)
+        {
+            auto sequence_size = get_utf8_sequence_size(data + i, size - i);
+            if (sequence_size == 0)
+            {
+                return i;
+            }
+            i += sequence_size;
+        }
+    }
+}
+
+struct CpuidResult
+{
+    u32 eax;
+    u32 ebx;
+    u32 ecx;
+    u32 edx;
+};
+
+CpuidResult cpuid(u32 leaf, u32 subleaf = 0)
+{
+    CpuidResult result;
+    asm volatile("cpuid" : "=a"(result.eax), "=b"(result.ebx), "=c"(result.ecx), "=d"(result.edx) : "a"(leaf), "c"(subleaf));
+    return result;
+}
+
+// nothing runs before _start to check this up front, so the first caller does
+bool is_avx2_checked;
+bool is_avx2_present;
+
+// the CPU has to have the instructions, and the kernel has to save the 256-bit registers on context switches
+bool is_avx2_available()
+{
+    if (!is_avx2_checked)
+    {
+        is_avx2_checked = true;
+        auto features = cpuid(1);
+        auto has_xsave_and_avx = (features.ecx & (1 << 27)) != 0 && (features.ecx & (1 << 28)) != 0;
+        if (cpuid(0).eax >= 7 && has_xsave_and_avx)
+        {
+            u32 saved_low;
+            u32 saved_high;
+            asm volatile("xgetbv" : "=a"(saved_low), "=d"(saved_high) : "c"(0));
+            auto are_ymm_saved = (saved_low & 0x6) == 0x6; // the SSE and AVX state
+            is_avx2_present = are_ymm_saved && (cpuid(7).ebx & (1 << 5)) != 0;
+        }
+    }
+    return is_avx2_present;
+}
+
+// the AVX2 validator from Keiser and Lemire's "Validating UTF-8 In Less Than One Instruction Per Byte": each byte
+// is looked up in three 16-entry tables, by the high and the low nibble of the byte before it and by its own high
+// nibble, and a bit survives the and of the three lookups only where that pair of bytes is an error of its kind;
+// the build is -mno-sse, so the 256-bit registers only show up in functions marked with the target, and those
+// only run after is_avx2_available
+
+enum Utf8Error : u8
+{
+    Utf8ErrorTooShort = 1 << 0, // a lead, then no continuation
+    Utf8ErrorTooLong = 1 << 1, // ASCII, then a continuation
+    Utf8ErrorOverlong3 = 1 << 2, // E0, then 80 to 9F
+    Utf8ErrorTooLarge = 1 << 3, // F4, then 90 to BF, or F5 to FF, then 90 to BF
+    Utf8ErrorSurrogate = 1 << 4, // ED, then A0 to BF
+    Utf8ErrorOverlong2 = 1 << 5, // C0 or C1, then a continuation
+    Utf8ErrorTooLarge1000 = 1 << 6, // F5 to FF, then 80 to 8F
+    Utf8ErrorOverlong4 = 1 << 6, // F0, then 80 to 8F; shares the bit, the first bytes of the two don't overlap
+    Utf8ErrorTwoContinuations = 1 << 7, // a continuation, then another, only fine as a sequence's third or fourth byte
+    Utf8ErrorAnyLow = Utf8ErrorTooShort | Utf8ErrorTooLong | Utf8ErrorTwoContinuations, // whatever the low nibble
+};
+
+const u8 UTF8_FIRST_HIGH_ERRORS[16] = {
+    Utf8ErrorTooLong, Utf8ErrorTooLong, Utf8ErrorTooLong, Utf8ErrorTooLong, // 0___
+    Utf8ErrorTooLong, Utf8ErrorTooLong, Utf8ErrorTooLong, Utf8ErrorTooLong,
+    Utf8ErrorTwoContinuations, Utf8ErrorTwoContinuations, Utf8ErrorTwoContinuations, Utf8ErrorTwoContinuations, // 10__
+    Utf8ErrorTooShort | Utf8ErrorOverlong2, // 1100
+    Utf8ErrorTooShort, // 1101
+    Utf8ErrorTooShort | Utf8ErrorOverlong3 | Utf8ErrorSurrogate, // 1110
+    Utf8ErrorTooShort | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000 | Utf8ErrorOverlong4, // 1111
+};
+
+const u8 UTF8_FIRST_LOW_ERRORS[16] = {
+    Utf8ErrorAnyLow | Utf8ErrorOverlong3 | Utf8ErrorOverlong2 | Utf8ErrorOverlong4, // 0000
+    Utf8ErrorAnyLow | Utf8ErrorOverlong2, // 0001
+    Utf8ErrorAnyLow, // 0010
+    Utf8ErrorAnyLow, // 0011
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge, // 0100
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000, // 0101 to 1100
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000,
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000,
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000,
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000,
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000,
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000,
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000,
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000 | Utf8ErrorSurrogate, // 1101
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000, // 1110
+    Utf8ErrorAnyLow | Utf8ErrorTooLarge | Utf8ErrorTooLarge1000, // 1111
+};
+
+const u8 UTF8_SECOND_HIGH_ERRORS[16] = {
+    Utf8ErrorTooShort, Utf8ErrorTooShort, Utf8ErrorTooShort, Utf8ErrorTooShort, // 0___
+    Utf8ErrorTooShort, Utf8ErrorTooShort, Utf8ErrorTooShort, Utf8ErrorTooShort,
+    Utf8ErrorTooLong | Utf8ErrorOverlong2 | Utf8ErrorTwoContinuations | Utf8ErrorOverlong3 | Utf8ErrorTooLarge1000 | Utf8ErrorOverlong4, // 1000
+    Utf8ErrorTooLong | Utf8ErrorOverlong2 | Utf8ErrorTwoContinuations | Utf8ErrorOverlong3 | Utf8ErrorTooLarge, // 1001
+    Utf8ErrorTooLong | Utf8ErrorOverlong2 | Utf8ErrorTwoContinuations | Utf8ErrorSurrogate | Utf8ErrorTooLarge, // 101_
+    Utf8ErrorTooLong | Utf8ErrorOverlong2 | Utf8ErrorTwoContinuations | Utf8ErrorSurrogate | Utf8ErrorTooLarge,
+    Utf8ErrorTooShort, Utf8ErrorTooShort, Utf8ErrorTooShort, Utf8ErrorTooShort, // 11__
+};
+
+typedef char __attribute__((vector_size(32))) Avx2Bytes;
+typedef char __attribute__((vector_size(32), may_alias, aligned(1))) UnalignedAvx2Bytes;
+typedef long long __attribute__((vector_size(32))) Avx2Quadwords; // what the whole-register builtins take
+
+// how far from the start of data the text is known to be valid, 32-byte blocks at a time; it ends where a sequence
+// starts, so find_invalid_utf8_scalar can go on from there
+__attribute__((target("avx2")))
+u64 validate_utf8_avx2(byte* data, u64 size)
+{
+    Avx2Bytes first_high_table;
+    Avx2Bytes first_low_table;
+    Avx2Bytes second_high_table;
+    Avx2Bytes third_byte_bias;
+    Avx2Bytes fourth_byte_bias;
+    Avx2Bytes incomplete_bias;
+    Avx2Bytes high_bits;
+    for (u64 i = 0; i < 32; i++)
+    { // the shuffle looks up within each 16-byte half, so both halves get the table
+        first_high_table[i] = UTF8_FIRST_HIGH_ERRORS[i % 16];
+        first_low_table[i] = UTF8_FIRST_LOW_ERRORS[i % 16];
+        second_high_table[i] = UTF8_SECOND_HIGH_ERRORS[i % 16];
+        third_byte_bias[i] = 0xE0 - 0x80; // subtracted with saturation, the high bit is left for E0 and above
+        fourth_byte_bias[i] = 0xF0 - 0x80;
+        // leaves something of a block's last three bytes where they start a sequence that needs more of them
+        incomplete_bias[i] = i == 29 ? 0xF0 - 1 : i == 30 ? 0xE0 - 1 : i == 31 ? 0xC0 - 1 : 0xFF;
+        high_bits[i] = 0x80;
+    }
+
+    Avx2Bytes previous = {}; // as if ASCII came before
+    u64 i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        Avx2Bytes input = *(UnalignedAvx2Bytes*)(data + i);
+        if (__builtin_ia32_ptestz256((Avx2Quadwords)input, (Avx2Quadwords)high_bits))
+        { // ASCII is only an error when the block before ended in the middle of a sequence
+            auto incomplete = __builtin_ia32_psubusb256(previous, incomplete_bias);
+            if (!__builtin_ia32_ptestz256((Avx2Quadwords)incomplete, (Avx2Quadwords)incomplete))
+            {
+                break;
+            }
+            previous = input;
+            continue;
+        }
+        // the bytes 1, 2 and 3 places back; the byte shift stays within 16-byte halves, so the low half is
+        // shifted in from the upper half of the previous block
+        auto shifted_in = (Avx2Quadwords)__builtin_ia32_permti256((Avx2Quadwords)previous, (Avx2Quadwords)input, 0x21);
+        auto back_1 = (Avx2Bytes)__builtin_ia32_palignr256((Avx2Quadwords)input, shifted_in, 15 * 8);
+        auto back_2 = (Avx2Bytes)__builtin_ia32_palignr256((Avx2Quadwords)input, shifted_in, 14 * 8);
+        auto back_3 = (Avx2Bytes)__builtin_ia32_palignr256((Avx2Quadwords)input, shifted_in, 13 * 8);
+
+        auto errors = __builtin_ia32_pshufb256(first_high_table, (back_1 >> 4) & 0x0F)
+            & __builtin_ia32_pshufb256(first_low_table, back_1 & 0x0F)
+            & __builtin_ia32_pshufb256(second_high_table, (input >> 4) & 0x0F);
+        // two continuations in a row have to be a third or fourth byte, and those have to be one
+        auto is_third_or_fourth = __builtin_ia32_psubusb256(back_2, third_byte_bias)
+            | __builtin_ia32_psubusb256(back_3, fourth_byte_bias);
+        errors ^= is_third_or_fourth & (char)0x80;
+        if (!__builtin_ia32_ptestz256((Avx2Quadwords)errors, (Avx2Quadwords)errors))
+        {
+            break;
+        }
+        previous = input;
+    }
+
+    // the last sequence before i may go on past it, or be where the error is
+    for (u64 back = 1; back <= min(i, (u64)3); back++)
+    {
+        auto value = data[i - back];
+        if (value < 0x80)
+        {
+            break;
+        }
+        if (value >= 0xC0)
+        {
+            return i - back;
+        }
+    }
+    return i;
+}
+
+// offset of the first byte of the first invalid or truncated sequence, or size if all of it is valid
+u64 find_invalid_utf8(byte* data, u64 size)
+{
+    u64 valid_size = 0;
+    if (size >= 32 && is_avx2_available())
+    {
+        valid_size = validate_utf8_avx2(data, size);
+    }
+    return valid_size + find_invalid_utf8_scalar(data + valid_size, size - valid_size);
+}
+
+// decodes like decode_utf8_codepoint does, but a whole buffer at a time; `codepoints` needs room for `size` values,
+// returns how many were written
+u64 decode_utf8(byte* data, u64 size, u32* codepoints)
+{
+    u64 count = 0;
+    u64 i = 0;
+    while (i < size)
+    {
+        while (i + 8 <= size && (*(u64*)(data + i) & ASCII_HIGH_BITS) == 0)
+        {
+            for (u64 j = 0; j < 8; j++)
+            {
+                codepoints[count + j] = data[i + j];
+            }
+            count += 8;
+            i += 8;
+        }
+        if (i == size)
+        {
+            break;
+        }
+
+        if (data[i] < 0x80)
+        {
+            codepoints[count] = data[i];
+            i++;
+        }
+        else
+        {
+            auto sequence_size = get_utf8_sequence_size(data + i, size - i);
+            if (sequence_size == 0)
+            { // resynchronize on the next byte
+                codepoints[count] = UNICODE_REPLACEMENT_CHARACTER;
+                i++;
+            }
+            else
+            {
+                u32 codepoint = data[i] & UTF8_LEAD_TABLE.leads[data[i]].payload_mask;
+                for (u64 j = 1; j < sequence_size; j++)
+                {
+                    codepoint = (codepoint << 6) | (data[i + j] & 0x3F);
+                }
+                codepoints[count] = codepoint;
+                i += sequence_size;
+            }
+        }
+        count++;
+    }
+    return count;
+}
+
+// every byte that isn't part of a valid sequence gets overwritten with `replacement`,
+// valid text costs no more than validating it
+void replace_invalid_utf8(byte* data, u64 size, byte replacement)
+{
+    u64 i = 0;
+    while (true)
+    {
+        i += find_invalid_utf8(data + i, size - i);
+        if (i == size)
+        {
+            break;
+        }
+        data[i] = replacement;
+        i++;
+    }
+}
@@ -60,6 +60,11 @@ enum X11RequestType : s8
 {
     X11RequestTypeCreateWindow = 1,
     X11RequestTypeMapWindow = 8,
+    X11RequestTypeInternAtom = 16,
+    X11RequestTypeDeleteProperty = 19,
+    X11RequestTypeGetProperty = 20,
+    X11RequestTypeConvertSelection = 24,
+    X11RequestTypeGetInputFocus = 43,
     X11RequestTypeCreateGraphicsContext = 55,
     X11RequestTypePutImage = 72,
 };
@@ -158,6 +163,15 @@ struct X11MapWindowRequest
     u32 window_id;
 };
 
+// has no arguments and a reply that carries nothing we need, which makes it a cheap round trip:
+// once its reply is in, every request sent before it has been processed
+struct X11GetInputFocusRequest
+{
+    X11RequestType type;
+    byte UNUSED;
+    u16 request_size_in_dwords;
+};
+
 struct X11CreateGraphicsContextRequest
 {
     X11RequestType type;
@@ -193,9 +207,14 @@ struct X11PutImageRequestHeader
 
 enum X11EventType : u8
 {
+    X11EventTypeError = 0, // not actually events, but they arrive the same way
+    X11EventTypeReply = 1,
     X11EventTypeKeyPress = 2,
     X11EventTypeButtonPress = 4,
     X11EventTypeExpose = 12,
+    X11EventTypeConfigureNotify = 22,
+    X11EventTypePropertyNotify = 28,
+    X11EventTypeSelectionNotify = 31,
 };
 
 struct X11Event
@@ -294,6 +313,20 @@ enum X11KeyCode : u8
     X11KeyCodeCtrlLeft = 37,
     X11KeyCodeSpace = 65,
     X11KeyCodeCtrlRight = 109,
+    X11KeyCodeUp = 98,
+    X11KeyCodeLeft = 100,
+    X11KeyCodeRight = 102,
+    X11KeyCodeDown = 104,
+};
+
+// the detail of a ButtonPress
+enum X11Button : u8
+{
+    X11ButtonLeft = 1,
+    X11ButtonMiddle = 2,
+    X11ButtonRight = 3,
+    X11ButtonScrollUp = 4,
+    X11ButtonScrollDown = 5,
 };
 
 enum X11ModifierKey : u16
@@ -456,7 +489,146 @@ struct X11EventExpose
     byte unused2[14];
 };
 
+// sent for StructureNotify whenever the window is moved, resized or restacked
+struct X11EventConfigureNotify
+{
+    X11EventType type;
+    byte unused1;
+    u16 sequence_number;
+    u32 event_window_id;
+    u32 window_id;
+    u32 above_sibling_window_id;
+    s16 x;
+    s16 y;
+    u16 width;
+    u16 height;
+    u16 border_width;
+    bool override_redirect;
+    byte unused2[5];
+};
+
 u64 x11_calculate_padding(u64 value)
 {
     return (4 - (value % 4)) % 4;
 }
+
+// selections and properties
+
+typedef u32 X11Atom;
+
+const X11Atom X11_ATOM_NONE = 0;
+const X11Atom X11_ATOM_ANY_PROPERTY_TYPE = 0;
+const X11Atom X11_ATOM_PRIMARY = 1;
+const X11Atom X11_ATOM_STRING = 31;
+const u32 X11_CURRENT_TIME = 0;
+
+struct X11InternAtomRequestHeader
+{
+    X11RequestType type;
+    bool only_if_exists;
+    u16 request_size_in_dwords;
+    u16 name_size;
+    byte UNUSED[2];
+    // followed by the name, padded to 4 bytes
+};
+
+struct X11InternAtomReply
+{
+    X11EventType type;
+    byte UNUSED1;
+    u16 sequence_number;
+    u32 reply_size_in_dwords;
+    X11Atom atom;
+    byte UNUSED2[20];
+};
+
+struct X11ConvertSelectionRequest
+{
+    X11RequestType type;
+    byte UNUSED;
+    u16 request_size_in_dwords;
+    u32 requestor_window_id;
+    X11Atom selection;
+    X11Atom target;
+    X11Atom property;
+    u32 time;
+};
+
+struct X11GetPropertyRequest
+{
+    X11RequestType type;
+    bool should_delete;
+    u16 request_size_in_dwords;
+    u32 window_id;
+    X11Atom property;
+    X11Atom property_type;
+    u32 offset_in_dwords;
+    u32 size_in_dwords;
+};
+
+struct X11GetPropertyReplyHeader
+{
+    X11EventType type;
+    u8 format; // bits per value: 8, 16 or 32
+    u16 sequence_number;
+    u32 reply_size_in_dwords; // of what follows this header
+    X11Atom property_type;
+    u32 bytes_after;
+    u32 value_count; // in units of format
+    byte UNUSED[12];
+};
+
+struct X11DeletePropertyRequest
+{
+    X11RequestType type;
+    byte UNUSED;
+    u16 request_size_in_dwords;
+    u32 window_id;
+    X11Atom property;
+};
+
+struct X11EventSelectionNotify
+{
+    X11EventType type;
+    byte unused1;
+    u16 sequence_number;
+    u32 time;
+    u32 requestor_window_id;
+    X11Atom selection;
+    X11Atom target;
+    X11Atom property; // X11_ATOM_NONE if the conversion failed
+    byte unused2[8];
+};
+
+enum X11PropertyState : u8
+{
+    X11PropertyStateNewValue = 0,
+    X11PropertyStateDeleted = 1,
+};
+
+struct X11EventPropertyNotify
+{
+    X11EventType type;
+    byte unused1;
+    u16 sequence_number;
+    u32 window_id;
+    X11Atom property;
+    u32 time;
+    X11PropertyState state;
+    byte unused2[15];
+};
+
+// the window that an event is about, 0 for errors, replies and events that aren't about a window
+u32 get_x11_event_window_id(X11Event* event)
+{
+    switch (event->type & 0x7F) // the top bit is set on events sent by other clients
+    {
+        case X11EventTypeKeyPress: return ((X11EventKeyPress*)event)->event;
+        case X11EventTypeButtonPress: return ((X11EventKeyPress*)event)->event; // same layout
+        case X11EventTypeExpose: return ((X11EventExpose*)event)->window_id;
+        case X11EventTypeConfigureNotify: return ((X11EventConfigureNotify*)event)->window_id;
+        case X11EventTypePropertyNotify: return ((X11EventPropertyNotify*)event)->window_id;
+        case X11EventTypeSelectionNotify: return ((X11EventSelectionNotify*)event)->requestor_window_id;
+        default: return 0;
+    }
+}
@@ -0,0 +1,162 @@
+// connecting to the display server, creating the window and getting images onto it
+
+const char X11_SOCKET_PATH[] = "/tmp/.X11-unix/X0";
+CStringView XAUTHORITY_PATH = "/run/user/1000/gdm/Xauthority"; // TODO: make this user-independent
+const s16 TARGET_X11_MAJOR_VERSION = 11;
+const s16 TARGET_X11_MINOR_VERSION = 0;
+const u16 DEPTH = 24;
+const u32 WINDOW_WIDTH = 512 * 2; // when created, windows can be resized afterwards
+const u32 WINDOW_HEIGHT = 512;
+const u64 X11_MAX_REQUEST_SIZE = 512 * 100 * 4; // in bytes
+
+// the connection setup on an already connected socket, `x11_cookie` is MIT_COOKIE_SIZE bytes
+X11Connection x11_handshake(Descriptor x11_socket, byte* x11_cookie)
+{
+    // connection request
+    X11ConnectionRequest connection_request;
+    connection_request.order = X11EndiannessLittle;
+    connection_request.protocol_major_version = TARGET_X11_MAJOR_VERSION;
+    connection_request.protocol_minor_version = TARGET_X11_MINOR_VERSION;
+    connection_request.authorization_protocol_name_size = get_c_string_length(MIT_COOKIE_PROTOCOL_NAME);
+    connection_request.authorization_protocol_data_size = MIT_COOKIE_SIZE;
+    copy_memory(MIT_COOKIE_PROTOCOL_NAME, get_c_string_length(MIT_COOKIE_PROTOCOL_NAME), &connection_request.authorization_protocol_name);
+    copy_memory(x11_cookie, MIT_COOKIE_SIZE, &connection_request.authorization_protocol_data);
+    auto write_connection_request_result = write(x11_socket, &connection_request, sizeof(X11ConnectionRequest));
+    assert(write_connection_request_result == sizeof(X11ConnectionRequest), "Failed to send connection request");
+
+    // connection response header
+    X11ConnectionResponseHeader connection_response_header;
+    auto read_connection_response_header_result = read(x11_socket, &connection_response_header, sizeof(connection_response_header));
+    assert(read_connection_response_header_result == sizeof(connection_response_header), "Failed to read connection response header");
+    assert(connection_response_header.status == X11ConnectionStatusSuccess, "Failed to authenticate with X11");
+
+    // connection response body
+    u64 connection_response_body_size = connection_response_header.body_size_in_dwords * 4;
+    auto connection_response_body = default_allocate(connection_response_body_size);
+    auto read_connection_response_body_result = read(x11_socket, connection_response_body, connection_response_body_size);
+    assert(read_connection_response_body_result == (s64)connection_response_body_size, "Failed to read connection response body");
+
+    auto connection_response_body_initial = (X11ConnectionResponseBodyInitial*)connection_response_body;
+    auto base_id = connection_response_body_initial->base_id;
+    auto id_mask = connection_response_body_initial->id_mask;
+    auto screen_id = *(u32*)(
+        connection_response_body
+            + sizeof(X11ConnectionResponseBodyInitial)
+            + connection_response_body_initial->vendor_len
+            + connection_response_body_initial->num_pixmap_formats * 8
+    );
+
+    default_deallocate(connection_response_body);
+
+    return X11Connection::construct(x11_socket, screen_id, base_id, id_mask);
+}
+
+X11Connection connect_to_x11()
+{
+    auto x11_socket = socket(SocketDomainUnix, SocketTypeTcp);
+    assert(x11_socket != -1, "Failed to open X11 socket");
+
+    UnixSocketAddress x11_socket_address;
+    x11_socket_address.family = SocketDomainUnix;
+    copy_memory(X11_SOCKET_PATH, sizeof(X11_SOCKET_PATH) + 1 /* include zero terminator */, &x11_socket_address.path);
+    auto connect_result = connect(x11_socket, &x11_socket_address, sizeof(x11_socket_address));
+    assert(connect_result == 0, "Connect failed");
+
+    auto xauthority_contents = read_whole_file(XAUTHORITY_PATH).unwrap("Failed to read Xauthority");
+    auto x11_cookie = xauthority_contents.data + xauthority_contents.size - MIT_COOKIE_SIZE;
+    return x11_handshake(x11_socket, (byte*)x11_cookie);
+}
+
+struct X11Window
+{
+    u32 id;
+    u32 gc_id;
+};
+
+// one graphics context is enough for any number of windows on the same screen and depth
+u32 create_x11_graphics_context(X11Connection* x11_connection)
+{
+    auto graphics_context_id = x11_connection->allocate_id();
+    X11CreateGraphicsContextRequest create_graphics_context_request;
+    create_graphics_context_request.type = X11RequestTypeCreateGraphicsContext;
+    create_graphics_context_request.request_size_in_dwords = sizeof(X11CreateGraphicsContextRequest) / 4;
+    create_graphics_context_request.graphics_context_id = graphics_context_id;
+    create_graphics_context_request.drawable_id = x11_connection->screen_id;
+    create_graphics_context_request.value_mask = 0;
+    x11_connection->send_request("create graphics context", &create_graphics_context_request, sizeof(create_graphics_context_request));
+    return graphics_context_id;
+}
+
+// nothing should be drawn into the window before x11_connection->wait_for_expose(window.id), otherwise there is
+// a risk that the X server skips the first frame; windows can be created in bulk and waited for afterwards
+X11Window create_x11_window(X11Connection* x11_connection, u32 graphics_context_id, u32 width = WINDOW_WIDTH, u32 height = WINDOW_HEIGHT)
+{
+    auto window_id = x11_connection->allocate_id();
+
+    // create window
+    u32 create_window_request_body[3] =
+    {
+        0x00FFFF00, // background
+        0x00FF0000, // border
+        X11EventMarkExposure | X11EventMarkButtonPress | X11EventMarkKeyPress | X11EventMarkPropertyChange | X11EventMarkStructureNotify, // events
+    };
+    X11CreateWindowRequestHeader create_window_request_header;
+    create_window_request_header.type = X11RequestTypeCreateWindow;
+    create_window_request_header.depth = DEPTH;
+    create_window_request_header.request_size_in_dwords = (sizeof(create_window_request_header) + sizeof(create_window_request_body)) / 4;
+    create_window_request_header.window_id = window_id;
+    create_window_request_header.parent_id = x11_connection->screen_id;
+    create_window_request_header.position_x = 0;
+    create_window_request_header.position_y = 0;
+    create_window_request_header.width = width;
+    create_window_request_header.height = height;
+    create_window_request_header.border_width = 20;
+    create_window_request_header.window_class = X11WindowClassCopyFromParent;
+    create_window_request_header.visual_id = X11_VISUAL_ID_COPY_FROM_PARENT;
+    create_window_request_header.value_mask = X11WindowAttributeBackgroundPixel | X11WindowAttributeBorderPixel | X11WindowAttributeEventMask;
+    x11_connection->send_request("create window", &create_window_request_header, sizeof(create_window_request_header), &create_window_request_body, sizeof(create_window_request_body));
+
+    // map window
+    X11MapWindowRequest map_window_request;
+    map_window_request.type = X11RequestTypeMapWindow;
+    map_window_request.request_size_in_dwords = sizeof(X11MapWindowRequest) / 4;
+    map_window_request.window_id = window_id;
+    x11_connection->send_request("map window", &map_window_request, sizeof(map_window_request));
+
+    X11Window result;
+    result.id = window_id;
+    result.gc_id = graphics_context_id;
+    return result;
+}
+
+// only queues the requests, `image` has to stay unchanged until x11_connection->flush();
+// whole rows are sent, padding included, the server clips the padding away at the window's right edge
+void put_image_in_chunks(X11Connection* x11_connection, X11Window x11_window, Image image)
+{
+    auto zone = profile_begin("put_image_in_chunks");
+    X11PutImageRequestHeader put_image_request_header;
+    put_image_request_header.type = X11RequestTypePutImage;
+    put_image_request_header.format = X11ImageFormatZPixmap;
+    put_image_request_header.drawable_id = x11_window.id;
+    put_image_request_header.graphics_context_id = x11_window.gc_id;
+    put_image_request_header.depth = DEPTH;
+
+    // as many whole rows per request as fit, but at least one
+    u64 line_size = image.stride * sizeof(Pixel);
+    u64 rows_per_request = max((X11_MAX_REQUEST_SIZE - sizeof(put_image_request_header)) / max(line_size, (u64)1), (u64)1);
+    for (u64 y = 0; y < image.height && image.width != 0; y += rows_per_request)
+    {
+        auto batch_height = min(rows_per_request, image.height - y);
+        auto batch_size = batch_height * line_size;
+        put_image_request_header.request_size_in_dwords = (sizeof(put_image_request_header) + batch_size) / 4;
+        put_image_request_header.width = image.stride;
+        put_image_request_header.height = batch_height;
+        put_image_request_header.position_x = 0;
+        put_image_request_header.position_y = y;
+        put_image_request_header.left_pad = 0;
+
+        x11_connection->send_request("put image", &put_image_request_header, sizeof(put_image_request_header), image.data + y * image.stride, batch_size);
+    }
+
+    profile_end(zone);
+}
@@ -0,0 +1,269 @@
+// the client's side of a connection: sending requests, and reading whatever the server sends back;
+// requests are queued and written out together by flush, so a frame's requests for all windows take one syscall
+
+const u64 X11_OUTPUT_COPY_LIMIT = 4 * 1024; // request bodies up to this size are copied, bigger ones are only referenced
+
+// a run of queued bytes, either in the output buffer or in the caller's memory
+struct X11OutputPiece
+{
+    byte* data; // nullptr for bytes in the output buffer, which moves when it grows
+    u64 offset; // into the output buffer
+    u64 size;
+};
+
+struct X11Connection
+{
+    Descriptor socket;
+    u32 screen_id;
+    u32 base_id; // XIDs are base_id with some of id_mask's bits set
+    u32 id_mask;
+    u32 next_id_index;
+    u16 last_sequence_number; // of the last request queued, replies and errors refer to requests by it
+    List<X11Event> pending_events; // events that arrived while waiting for a reply
+    X11Trace* trace; // nullptr unless tracing
+
+    byte* output_buffer;
+    u64 output_size;
+    u64 output_capacity;
+    List<X11OutputPiece> output_pieces;
+
+    static X11Connection construct(Descriptor socket, u32 screen_id, u32 base_id, u32 id_mask)
+    {
+        X11Connection result;
+        result.socket = socket;
+        result.screen_id = screen_id;
+        result.base_id = base_id;
+        result.id_mask = id_mask;
+        result.next_id_index = 0;
+        result.last_sequence_number = 0;
+        result.pending_events = List<X11Event>::allocate();
+        result.trace = nullptr;
+        result.output_capacity = 64 * 1024;
+        result.output_buffer = heap_allocate(result.output_capacity);
+        result.output_size = 0;
+        result.output_pieces = List<X11OutputPiece>::allocate();
+        return result;
+    }
+
+    // a fresh id for a window, graphics context or any other resource
+    u32 allocate_id()
+    {
+        u64 step = id_mask & (~id_mask + 1); // the mask's lowest bit
+        u64 offset = next_id_index * step;
+        assert(step != 0 && offset <= id_mask, "X11Connection::allocate_id: out of resource ids");
+        next_id_index++;
+        return base_id | offset;
+    }
+
+    void queue_copy(void* data, u64 size)
+    {
+        if (output_size + size > output_capacity)
+        {
+            auto new_capacity = max(output_capacity * 2, output_size + size);
+            auto new_buffer = heap_allocate(new_capacity);
+            copy_memory(output_buffer, output_size, new_buffer);
+            default_deallocate(output_buffer);
+            output_buffer = new_buffer;
+            output_capacity = new_capacity;
+        }
+        copy_memory(data, size, output_buffer + output_size);
+        if (output_pieces.size != 0 && output_pieces.data[output_pieces.size - 1].data == nullptr)
+        { // adjacent copies are written as one piece
+            output_pieces.data[output_pieces.size - 1].size += size;
+        }
+        else
+        {
+            X11OutputPiece piece;
+            piece.data = nullptr;
+            piece.offset = output_size;
+            piece.size = size;
+            output_pieces.push(piece);
+        }
+        output_size += size;
+    }
+
+    // a big body, e.g. a PutImage's pixels, is written straight from where it is, so it has to stay unchanged
+    // until the next flush; returns the request's sequence number
+    u16 send_request(CStringView description, void* header, u64 header_size, void* body = nullptr, u64 body_size = 0)
+    {
+        assert((header_size + body_size) % 4 == 0, "Request size isn't a multiple of 4: ", description);
+        queue_copy(header, header_size);
+        if (body_size > X11_OUTPUT_COPY_LIMIT)
+        {
+            X11OutputPiece piece;
+            piece.data = (byte*)body;
+            piece.offset = 0;
+            piece.size = body_size;
+            output_pieces.push(piece);
+        }
+        else if (body_size != 0)
+        {
+            queue_copy(body, body_size);
+        }
+        last_sequence_number++;
+        if (trace != nullptr)
+        {
+            trace->record_request(last_sequence_number, header, header_size, body, body_size);
+        }
+        return last_sequence_number;
+    }
+
+    // writes out everything that was queued
+    void flush()
+    {
+        auto zone = profile_begin("X11Connection::flush");
+        IoVector vectors[LINUX_MAX_IO_VECTOR_COUNT];
+        u64 piece_i = 0;
+        u64 written_in_piece = 0; // when a write stopped in the middle of a piece
+        while (piece_i < output_pieces.size)
+        {
+            u64 vector_count = 0;
+            u64 total_size = 0;
+            for (auto i = piece_i; i < output_pieces.size && vector_count < LINUX_MAX_IO_VECTOR_COUNT; i++, vector_count++)
+            {
+                auto piece = output_pieces.data[i];
+                auto data = piece.data != nullptr ? piece.data : output_buffer + piece.offset;
+                auto skipped = i == piece_i ? written_in_piece : 0;
+                vectors[vector_count].data = data + skipped;
+                vectors[vector_count].size = piece.size - skipped;
+                total_size += piece.size - skipped;
+            }
+            auto write_result = write_vector(socket, vectors, vector_count);
+            assert(write_result > 0, "Failed to write requests to the X11 socket");
+            if ((u64)write_result == total_size)
+            {
+                piece_i += vector_count;
+                written_in_piece = 0;
+                continue;
+            }
+            // short write, continue where it stopped
+            u64 remaining = write_result;
+            while (remaining >= output_pieces.data[piece_i].size - written_in_piece)
+            {
+                remaining -= output_pieces.data[piece_i].size - written_in_piece;
+                piece_i++;
+                written_in_piece = 0;
+            }
+            written_in_piece += remaining;
+        }
+        output_pieces.clear();
+        output_size = 0;
+        profile_end(zone);
+    }
+
+    // socket reads can come back short when a reply is large
+    void read_exactly(void* buffer, u64 size)
+    {
+        u64 bytes_read = 0;
+        while (bytes_read != size)
+        {
+            auto read_result = read(socket, (byte*)buffer + bytes_read, size - bytes_read);
+            assert(read_result > 0, "Failed to read from X11 socket");
+            bytes_read += read_result;
+        }
+    }
+
+    // the first 32 bytes of an event, reply or error; replies can be longer, the rest has to be read before the next message
+    void read_message(X11Event* message)
+    {
+        read_exactly(message, sizeof(*message));
+        if (trace != nullptr)
+        {
+            trace->record_message(message);
+        }
+    }
+
+    void skip_bytes(u64 size)
+    {
+        byte buffer[256];
+        while (size != 0)
+        {
+            auto chunk_size = min(size, (u64)sizeof(buffer));
+            read_exactly(buffer, chunk_size);
+            size -= chunk_size;
+        }
+    }
+
+    // blocks until the reply to the request with the given sequence number arrives, only the first 32 bytes
+    // of the reply are read; events that arrive in the meantime are kept in pending_events
+    void wait_for_reply(u16 sequence_number, X11Event* reply)
+    {
+        flush();
+        while (true)
+        {
+            read_message(reply);
+            auto reply_sequence_number = *(u16*)(reply->data + 1);
+            if (reply->type == X11EventTypeError)
+            {
+                assert(reply_sequence_number != sequence_number, "X11 request failed with error code ", (u64)reply->data[0]);
+                continue;
+            }
+            if (reply->type == X11EventTypeReply)
+            {
+                if (reply_sequence_number == sequence_number)
+                {
+                    return;
+                }
+                skip_bytes(*(u32*)(reply->data + 3) * 4);
+                continue;
+            }
+            pending_events.push(*reply);
+        }
+    }
+
+    X11Atom intern_atom(CStringView name)
+    {
+        X11InternAtomRequestHeader request;
+        auto name_size = get_c_string_length(name);
+        byte body[256] = {};
+        assert(name_size <= sizeof(body), "intern_atom: name is too long");
+        copy_memory(name, name_size, body);
+        auto body_size = name_size + x11_calculate_padding(name_size);
+        request.type = X11RequestTypeInternAtom;
+        request.only_if_exists = false;
+        request.request_size_in_dwords = (sizeof(request) + body_size) / 4;
+        request.name_size = name_size;
+        auto sequence_number = send_request("intern atom", &request, sizeof(request), body, body_size);
+
+        X11Event reply;
+        wait_for_reply(sequence_number, &reply);
+        return ((X11InternAtomReply*)&reply)->atom;
+    }
+
+    // blocks until the window's first Expose, events that arrive in the meantime are kept in pending_events
+    void wait_for_expose(u32 window_id)
+    {
+        flush();
+        for (u64 i = 0; i < pending_events.size; i++)
+        {
+            if (pending_events.data[i].type == X11EventTypeExpose && ((X11EventExpose*)&pending_events.data[i])->window_id == window_id)
+            {
+                return;
+            }
+        }
+        while (true)
+        {
+            X11Event event;
+            read_message(&event);
+            if (event.type == X11EventTypeReply)
+            {
+                skip_bytes(*(u32*)(event.data + 3) * 4);
+                continue;
+            }
+            pending_events.push(event);
+            if (event.type == X11EventTypeExpose && ((X11EventExpose*)&event)->window_id == window_id)
+            {
+                return;
+            }
+        }
+    }
+
+    void dispose()
+    {
+        flush();
+        output_pieces.deallocate();
+        default_deallocate(output_buffer);
+        pending_events.deallocate();
+        close(socket);
+    }
+};
@@ -0,0 +1,171 @@
+// opt-in binary trace of everything that crosses the X11 socket: one fixed-size record per request, event,
+// reply and error, plus a mark at the end of every frame; records go into a ring buffer that's written to a file
+// a slice at a time between frames, so tracing never blocks on the disk in the middle of a frame;
+// x11_trace_decode.bin turns the file into per-frame summaries
+
+const u64 X11_TRACE_MAGIC = 0x4543415254313158; // "X11TRACE"
+const u32 X11_TRACE_VERSION = 1;
+const u64 X11_TRACE_MAX_PAYLOAD_PREFIX = 64;
+const u64 X11_TRACE_RECORD_COUNT = 16 * 1024; // has to be a power of two
+const u64 X11_TRACE_FLUSH_SLICE = 256 * 1024; // at most this many bytes are written to the file per flush_slice call
+
+enum X11TraceRecordKind : u8
+{
+    X11TraceRecordKindRequest,
+    X11TraceRecordKindEvent,
+    X11TraceRecordKindReply,
+    X11TraceRecordKindError,
+    X11TraceRecordKindFrameEnd, // size is the number of records dropped since the previous frame end
+};
+
+struct X11TraceFileHeader
+{
+    u64 magic;
+    u32 version;
+    u32 record_size; // X11TraceRecord followed by the payload prefix
+    u64 nanoseconds_per_tick; // 32.32 fixed point, for the record times
+};
+
+struct X11TraceRecord
+{
+    u64 ticks; // time stamp counter
+    X11TraceRecordKind kind;
+    u8 opcode; // request or event type, error code for errors
+    u16 sequence_number;
+    u32 size; // in bytes, on the wire
+    // followed by the first payload_prefix_size bytes of the message, zero-padded
+};
+
+struct X11Trace
+{
+    Descriptor file;
+    u64 payload_prefix_size;
+    u64 record_size;
+    byte* records; // ring buffer of X11_TRACE_RECORD_COUNT records
+    u64 written_count; // records ever written, the ring index is written_count % X11_TRACE_RECORD_COUNT
+    u64 flushed_count;
+    u64 dropped_count; // since the last frame end
+
+    static Option<X11Trace> open(CStringView path, u64 payload_prefix_size = 0)
+    {
+        assert(payload_prefix_size <= X11_TRACE_MAX_PAYLOAD_PREFIX, "X11Trace::open: payload prefix is too long");
+        auto maybe_file = open_file_for_writing(path);
+        if (!maybe_file.has_data)
+        {
+            return Option<X11Trace>::empty();
+        }
+
+        X11Trace result;
+        result.file = maybe_file.value;
+        result.payload_prefix_size = payload_prefix_size;
+        result.record_size = sizeof(X11TraceRecord) + payload_prefix_size;
+        result.records = map_memory(
+            X11_TRACE_RECORD_COUNT * result.record_size,
+            LINUX_PROTECTION_READ | LINUX_PROTECTION_WRITE,
+            LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS
+        );
+        assert(result.records != nullptr, "X11Trace::open: failed to allocate the record buffer");
+        result.written_count = 0;
+        result.flushed_count = 0;
+        result.dropped_count = 0;
+
+        X11TraceFileHeader header;
+        header.magic = X11_TRACE_MAGIC;
+        header.version = X11_TRACE_VERSION;
+        header.record_size = result.record_size;
+        header.nanoseconds_per_tick = get_nanoseconds_per_tick();
+        auto write_result = write(result.file, &header, sizeof(header));
+        assert(write_result == sizeof(header), "X11Trace::open: failed to write the file header");
+        return Option<X11Trace>::construct(result);
+    }
+
+    // writes out everything that's left
+    void close_file()
+    {
+        while (flushed_count != written_count)
+        {
+            flush_slice();
+        }
+        close(file);
+        unmap_memory(records, X11_TRACE_RECORD_COUNT * record_size);
+    }
+
+    // `payload` and `second_payload` are the message's parts in order, e.g. a request's header and body
+    void record(X11TraceRecordKind kind, u8 opcode, u16 sequence_number, u64 size, void* payload, u64 payload_size, void* second_payload = nullptr, u64 second_payload_size = 0)
+    {
+        if (written_count - flushed_count == X11_TRACE_RECORD_COUNT && kind != X11TraceRecordKindFrameEnd)
+        { // the file can't keep up, new records are dropped rather than overwriting ones that weren't written yet
+            dropped_count++;
+            return;
+        }
+        if (written_count - flushed_count == X11_TRACE_RECORD_COUNT)
+        { // frame ends are what the decoder needs most, they replace the newest record instead
+            written_count--;
+            dropped_count++;
+        }
+        auto record = (X11TraceRecord*)(records + written_count % X11_TRACE_RECORD_COUNT * record_size);
+        record->ticks = read_time_stamp_counter();
+        record->kind = kind;
+        record->opcode = opcode;
+        record->sequence_number = sequence_number;
+        record->size = size;
+        auto prefix = (byte*)(record + 1);
+        auto first_size = min(payload_size, payload_prefix_size);
+        auto second_size = min(second_payload_size, payload_prefix_size - first_size);
+        copy_memory(payload, first_size, prefix);
+        copy_memory(second_payload, second_size, prefix + first_size);
+        for (auto i = first_size + second_size; i < payload_prefix_size; i++)
+        {
+            prefix[i] = 0;
+        }
+        written_count++;
+    }
+
+    void record_request(u16 sequence_number, void* header, u64 header_size, void* body, u64 body_size)
+    {
+        record(X11TraceRecordKindRequest, *(u8*)header, sequence_number, header_size + body_size, header, header_size, body, body_size);
+    }
+
+    // the first 32 bytes of anything the server sends
+    void record_message(X11Event* message)
+    {
+        auto sequence_number = *(u16*)(message->data + 1);
+        switch (message->type)
+        {
+            case X11EventTypeError:
+                record(X11TraceRecordKindError, message->data[0], sequence_number, sizeof(*message), message, sizeof(*message));
+                break;
+            case X11EventTypeReply:
+                record(X11TraceRecordKindReply, 0, sequence_number, sizeof(*message) + *(u32*)(message->data + 3) * 4, message, sizeof(*message));
+                break;
+            default:
+                record(X11TraceRecordKindEvent, message->type & 0x7F, sequence_number, sizeof(*message), message, sizeof(*message));
+                break;
+        }
+    }
+
+    void record_frame_end(u16 last_sequence_number)
+    {
+        auto dropped = dropped_count;
+        dropped_count = 0;
+        record(X11TraceRecordKindFrameEnd, 0, last_sequence_number, dropped, nullptr, 0);
+    }
+
+    // meant to be called once per frame, after the frame was presented
+    void flush_slice()
+    {
+        u64 budget = X11_TRACE_FLUSH_SLICE;
+        while (flushed_count != written_count && budget >= record_size)
+        {
+            // contiguous records, up to the end of the ring
+            auto ring_index = flushed_count % X11_TRACE_RECORD_COUNT;
+            auto count = min(written_count - flushed_count, X11_TRACE_RECORD_COUNT - ring_index);
+            count = min(count, budget / record_size);
+            auto size = count * record_size;
+            auto write_result = write(file, records + ring_index * record_size, size);
+            assert(write_result == (s64)size, "X11Trace::flush_slice: failed to write the trace");
+            flushed_count += count;
+            budget -= size;
+        }
+    }
+};
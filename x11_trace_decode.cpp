@@ -0,0 +1,174 @@
+// prints a wire trace written by X11Trace as one summary line per frame, then totals per request type:
+// ./x11_trace_decode.bin [trace file, x11_trace.bin by default] [1 to print every record too]
+
+#include <mystd/include_linux.h>
+
+#pragma pack(push, 1)
+
+#include "syscalls.cpp"
+#include "profiler.cpp"
+#include "x11.cpp"
+#include "x11_trace.cpp"
+
+CStringView DEFAULT_TRACE_PATH = "x11_trace.bin";
+
+CStringView get_request_name(u8 opcode)
+{
+    switch (opcode)
+    {
+        case X11RequestTypeCreateWindow: return "CreateWindow";
+        case X11RequestTypeMapWindow: return "MapWindow";
+        case X11RequestTypeInternAtom: return "InternAtom";
+        case X11RequestTypeDeleteProperty: return "DeleteProperty";
+        case X11RequestTypeGetProperty: return "GetProperty";
+        case X11RequestTypeConvertSelection: return "ConvertSelection";
+        case X11RequestTypeGetInputFocus: return "GetInputFocus";
+        case X11RequestTypeCreateGraphicsContext: return "CreateGC";
+        case X11RequestTypePutImage: return "PutImage";
+        default: return nullptr;
+    }
+}
+
+CStringView get_record_kind_name(X11TraceRecordKind kind)
+{
+    switch (kind)
+    {
+        case X11TraceRecordKindRequest: return "request";
+        case X11TraceRecordKindEvent: return "event";
+        case X11TraceRecordKindReply: return "reply";
+        case X11TraceRecordKindError: return "error";
+        case X11TraceRecordKindFrameEnd: return "frame end";
+        default: return "unknown";
+    }
+}
+
+void print_request_type(u8 opcode)
+{
+    auto name = get_request_name(opcode);
+    if (name != nullptr)
+    {
+        print(name);
+    }
+    else
+    {
+        print("request ", (u64)opcode);
+    }
+}
+
+struct X11TraceTotals
+{
+    u64 request_count;
+    u64 bytes_sent;
+    u64 event_count;
+    u64 reply_count;
+    u64 error_count;
+    u64 bytes_received;
+    u64 dropped_count;
+    u64 request_counts[256];
+    u64 request_bytes[256];
+
+    void add(X11TraceRecord* record)
+    {
+        switch (record->kind)
+        {
+            case X11TraceRecordKindRequest:
+                request_count++;
+                bytes_sent += record->size;
+                request_counts[record->opcode]++;
+                request_bytes[record->opcode] += record->size;
+                break;
+            case X11TraceRecordKindEvent: event_count++; bytes_received += record->size; break;
+            case X11TraceRecordKindReply: reply_count++; bytes_received += record->size; break;
+            case X11TraceRecordKindError: error_count++; bytes_received += record->size; break;
+            case X11TraceRecordKindFrameEnd: dropped_count += record->size; break;
+        }
+    }
+
+    void print_requests_by_type()
+    {
+        for (u64 opcode = 0; opcode < 256; opcode++)
+        {
+            if (request_counts[opcode] != 0)
+            {
+                print(" ");
+                print_request_type(opcode);
+                print(" ", request_counts[opcode], "x/", request_bytes[opcode], "B");
+            }
+        }
+    }
+};
+
+extern "C" void _start()
+{
+    auto path = get_command_line_argument(1);
+    auto print_records = get_command_line_argument(2).has_data;
+    auto maybe_file = MappedFile::open(path.has_data ? path.value : DEFAULT_TRACE_PATH);
+    assert(maybe_file.has_data, "Failed to open the trace file");
+    auto file = maybe_file.value;
+    assert(file.size >= sizeof(X11TraceFileHeader), "The trace file is too short");
+    auto header = (X11TraceFileHeader*)file.data;
+    assert(header->magic == X11_TRACE_MAGIC && header->version == X11_TRACE_VERSION, "Not a trace file, or from another version");
+    assert(header->record_size >= sizeof(X11TraceRecord), "Invalid record size: ", (u64)header->record_size);
+
+    auto record_count = (file.size - sizeof(X11TraceFileHeader)) / header->record_size;
+    auto records = file.data + sizeof(X11TraceFileHeader);
+    u64 first_ticks = record_count != 0 ? ((X11TraceRecord*)records)->ticks : 0;
+    X11TraceTotals frame = {};
+    X11TraceTotals total = {};
+    u64 frame_index = 0;
+    u64 frame_start_ticks = first_ticks;
+    for (u64 i = 0; i < record_count; i++)
+    {
+        auto record = (X11TraceRecord*)(records + i * header->record_size);
+        frame.add(record);
+        total.add(record);
+        auto time = convert_ticks_to_nanoseconds(record->ticks - first_ticks, header->nanoseconds_per_tick);
+        if (print_records)
+        {
+            print("    ", time / 1000, " us ", get_record_kind_name(record->kind), " seq ", (u64)record->sequence_number, " size ", (u64)record->size);
+            if (record->kind == X11TraceRecordKindRequest)
+            {
+                print(" ");
+                print_request_type(record->opcode);
+            }
+            else if (record->kind != X11TraceRecordKindFrameEnd)
+            {
+                print(" code ", (u64)record->opcode);
+            }
+            print("\n");
+        }
+        if (record->kind != X11TraceRecordKindFrameEnd)
+        {
+            continue;
+        }
+
+        auto frame_time = convert_ticks_to_nanoseconds(record->ticks - frame_start_ticks, header->nanoseconds_per_tick);
+        print(
+            "frame ", frame_index, " at ", time / 1000, " us, ", frame_time / 1000, " us long: ",
+            frame.request_count, " requests (", frame.bytes_sent, " B), ",
+            frame.event_count, " events, ", frame.reply_count, " replies, ", frame.error_count, " errors (", frame.bytes_received, " B)"
+        );
+        if (frame.dropped_count != 0)
+        {
+            print(", ", frame.dropped_count, " records dropped");
+        }
+        print(";");
+        frame.print_requests_by_type();
+        print("\n");
+        frame = {};
+        frame_index++;
+        frame_start_ticks = record->ticks;
+    }
+
+    print(
+        "total: ", frame_index, " frames, ", record_count, " records, ",
+        total.request_count, " requests (", total.bytes_sent, " B), ",
+        total.event_count, " events, ", total.reply_count, " replies, ", total.error_count, " errors (", total.bytes_received, " B), ",
+        total.dropped_count, " records dropped;"
+    );
+    total.print_requests_by_type();
+    print("\n");
+
+    file.dispose();
+    exit(0);
+}